@@ -74,6 +74,10 @@
  * 
  * Notice how this correctly maps to DDRB register.
  * 
+ * Every register access below goes through BSP_IO_REGISTER(), which expands to exactly the dereference shown 
+ * above. A host simulation build defines BSP_IO_REGISTER() beforehand to redirect the accesses to a mock 
+ * register file instead. See src/drivers/host/host_io.h.
+ * 
  * @version 0.1
  * @date 2023-02-15
  * 
@@ -90,10 +94,23 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/* AVR Libraries */
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
 /* Available GPIOs on ATMega16U4 and ATMega32U4 */
 #include "kb_pin_def.h"
 
 
+/**
+ * @brief Accesses the 8-bit I/O Register at @p address. Usable as an lvalue. Can be defined before this file is 
+ * included to redirect register accesses, e.g. to a mock register file when simulating on a host.
+ */
+#ifndef BSP_IO_REGISTER
+	#define BSP_IO_REGISTER(address)				( *( (volatile uint8_t *)(address) ) )
+#endif
+
+
 
 /*--------------------------------------------------------------------------------------------------------------------------*/
 /*------------------------------------------------------ PUBLIC FUNCTIONS --------------------------------------------------*/
@@ -116,7 +133,7 @@ static inline void BSP_GPIO_Set_Pin_Type_Input_HiZ(KB_PINSIZE_T KB_PIN)
 	uint8_t pin = BSP_GET_PIN(KB_PIN);
 
 	/* DDRx Write - see file description for more details. */
-	*( (volatile uint8_t *)(0x21 + (0x03 * port)) ) &= ~(1U << pin);
+	BSP_IO_REGISTER(0x21 + (0x03 * port)) &= ~(1U << pin);
 }
 
 
@@ -139,8 +156,8 @@ static inline void BSP_GPIO_Set_Pin_Type_Input_Pullup(KB_PINSIZE_T KB_PIN)
 	uint8_t pin = BSP_GET_PIN(KB_PIN);
 
 	/* DDRx and PORTx Write - see file description for more details. */
-	*( (volatile uint8_t *)(0x21 + (0x03 * port)) ) &= ~(1U << pin);
-	*( (volatile uint8_t *)(0x22 + (0x03 * port)) ) |= (1U << pin);
+	BSP_IO_REGISTER(0x21 + (0x03 * port)) &= ~(1U << pin);
+	BSP_IO_REGISTER(0x22 + (0x03 * port)) |= (1U << pin);
 }
 
 
@@ -164,7 +181,7 @@ static inline void BSP_GPIO_Set_Pin_Type_Output_Push_Pull(KB_PINSIZE_T KB_PIN)
 	uint8_t pin = BSP_GET_PIN(KB_PIN);
 
 	/* DDRx Write - see file description for more details. */
-	*( (volatile uint8_t *)(0x21 + (0x03 * port)) ) |= (1U << pin);
+	BSP_IO_REGISTER(0x21 + (0x03 * port)) |= (1U << pin);
 }
 
 
@@ -185,7 +202,7 @@ static inline void BSP_GPIO_Set_Output_Push_Pull_High(KB_PINSIZE_T KB_PIN)
 	uint8_t pin = BSP_GET_PIN(KB_PIN);
 
 	/* PORTx Write - see file description for more details. */
-	*( (volatile uint8_t *)(0x22 + (0x03 * port)) ) |= (1U << pin);
+	BSP_IO_REGISTER(0x22 + (0x03 * port)) |= (1U << pin);
 }
 
 
@@ -206,7 +223,7 @@ static inline void BSP_GPIO_Set_Output_Push_Pull_Low(KB_PINSIZE_T KB_PIN)
 	uint8_t pin = BSP_GET_PIN(KB_PIN);
 
 	/* PORTx Write - see file description for more details. */
-	*( (volatile uint8_t *)(0x22 + (0x03 * port)) ) &= ~(1U << pin);
+	BSP_IO_REGISTER(0x22 + (0x03 * port)) &= ~(1U << pin);
 }
 
 
@@ -239,8 +256,143 @@ static inline bool BSP_GPIO_Read(KB_PINSIZE_T KB_PIN)
 	uint8_t pin = BSP_GET_PIN(KB_PIN);
 
 	/* PINx Read - see file description for more details. */
-	return ( *( (volatile uint8_t *)(0x20 + (0x03 * port)) ) & (1U << pin) );
+	return ( BSP_IO_REGISTER(0x20 + (0x03 * port)) & (1U << pin) );
+}
+
+
+/**
+ * @brief Width of a single GPIO Port's Input Register on ATMega16U4/ATMega32U4. Each bit of the value returned
+ * from BSP_GPIO_Read_Port() is one pin of the Port. I.e. bit 5 is the raw reading of Pin 5.
+ */
+typedef uint8_t BSP_GPIO_PORT_T;
+
+
+/**
+ * @brief Takes a raw reading of every pin on a ATMega16U4/ATMega32U4 GPIO Port with a single PINx Read. Used
+ * when multiple Keyboard Rows/Columns share the same Port so the Port only has to be read once instead of
+ * calling BSP_GPIO_Read() for every pin.
+ *
+ * @attention The pins of interest must be configured as Inputs by calling BSP_GPIO_Set_Pin_Type_Input_HiZ()
+ * or BSP_GPIO_Set_Pin_Type_Input_Pullup() before this function can be used.
+ *
+ * @param port The hardware-agnostic Port returned from BSP_GET_PORT(). I.e. BSP_GET_PORT(KB_PIN_PD3) is passed in
+ * to read PIND. Only values 1 to 5 inclusive are valid since only GPIO Peripheral B to GPIO Peripheral F are
+ * available on ATMega16U4/ATMega32U4. See file description for more details.
+ *
+ * @return The raw PINx register. Use (1U << BSP_GET_PIN(KB_PIN_Pxx)) to mask out the reading of an individual pin.
+ */
+static inline BSP_GPIO_PORT_T BSP_GPIO_Read_Port(uint8_t port);
+static inline BSP_GPIO_PORT_T BSP_GPIO_Read_Port(uint8_t port)
+{
+	/* PINx Read - see file description for more details. */
+	return ( BSP_IO_REGISTER(0x20 + (0x03 * port)) );
+}
+
+
+
+/*--------------------------------------------------------------------------------------------------------------------------*/
+/*--------------------------------------------------- WAKE INTERRUPTS ------------------------------------------------------*/
+/*--------------------------------------------------------------------------------------------------------------------------*/
+
+/**
+ * @brief Checks if a change on the ATMega16U4/ATMega32U4 GPIO can trigger an interrupt. Only PB0 - PB7 (PCINT0 - 
+ * PCINT7), PD0 - PD3 (INT0 - INT3) and PE6 (INT6) can. Every other pin must be polled.
+ * 
+ * @param KB_PIN The ATMega16U4/ATMega32U4 GPIO connected to the Keyboard Row/Column. This MUST be one of 
+ * the KB_PIN_Pxx definitions found in kb_pin_def.h.
+ * 
+ * @return True if BSP_GPIO_Enable_Wake() can be used on this pin. False otherwise.
+ */
+static inline bool BSP_GPIO_Wake_Capable(KB_PINSIZE_T KB_PIN);
+static inline bool BSP_GPIO_Wake_Capable(KB_PINSIZE_T KB_PIN)
+{
+	uint8_t port = BSP_GET_PORT(KB_PIN);
+	uint8_t pin = BSP_GET_PIN(KB_PIN);
+
+	return ( (port == BSP_GET_PORT(BSP_PORT_B)) || 
+			 ((port == BSP_GET_PORT(BSP_PORT_D)) && (pin <= 3U)) || 
+			 ((port == BSP_GET_PORT(BSP_PORT_E)) && (pin == 6U)) );
+}
+
+
+/**
+ * @brief Arms an interrupt on any edge of the ATMega16U4/ATMega32U4 GPIO. The interrupt executes the handler 
+ * passed into BSP_GPIO_WAKE_ISR(). Any edge that occurred before this call is discarded.
+ * 
+ * @attention The pin must be configured as an Input and BSP_GPIO_Wake_Capable() must return true for this pin.
+ * INT0 - INT3 and INT6 edges are detected using the I/O clock, so they cannot wake the CPU from sleep modes 
+ * deeper than Idle.
+ * 
+ * @param KB_PIN The ATMega16U4/ATMega32U4 GPIO connected to the Keyboard Row/Column. This MUST be one of 
+ * the KB_PIN_Pxx definitions found in kb_pin_def.h.
+ */
+static inline void BSP_GPIO_Enable_Wake(KB_PINSIZE_T KB_PIN);
+static inline void BSP_GPIO_Enable_Wake(KB_PINSIZE_T KB_PIN)
+{
+	uint8_t port = BSP_GET_PORT(KB_PIN);
+	uint8_t pin = BSP_GET_PIN(KB_PIN);
+
+	if (port == BSP_GET_PORT(BSP_PORT_B)) {
+		PCMSK0 |= (1U << pin);
+		PCIFR = (1U << PCIF0);
+		PCICR |= (1U << PCIE0);
+	}
+	else if (port == BSP_GET_PORT(BSP_PORT_D)) {
+		EICRA = (uint8_t)((EICRA & ~(0x03U << (2U * pin))) | (0x01U << (2U * pin))); /* Any edge. */
+		EIFR = (1U << pin);
+		EIMSK |= (1U << pin);
+	}
+	else {
+		EICRB = (uint8_t)((EICRB & ~(0x03U << ISC60)) | (0x01U << ISC60)); /* Any edge. */
+		EIFR = (1U << INTF6);
+		EIMSK |= (1U << INT6);
+	}
 }
 
 
+/**
+ * @brief Disarms the interrupt armed with BSP_GPIO_Enable_Wake().
+ * 
+ * @param KB_PIN The ATMega16U4/ATMega32U4 GPIO connected to the Keyboard Row/Column. This MUST be one of 
+ * the KB_PIN_Pxx definitions found in kb_pin_def.h.
+ */
+static inline void BSP_GPIO_Disable_Wake(KB_PINSIZE_T KB_PIN);
+static inline void BSP_GPIO_Disable_Wake(KB_PINSIZE_T KB_PIN)
+{
+	uint8_t port = BSP_GET_PORT(KB_PIN);
+	uint8_t pin = BSP_GET_PIN(KB_PIN);
+
+	if (port == BSP_GET_PORT(BSP_PORT_B)) {
+		PCMSK0 &= ~(1U << pin);
+		if (!PCMSK0) {
+			PCICR &= ~(1U << PCIE0);
+		}
+	}
+	else if (port == BSP_GET_PORT(BSP_PORT_D)) {
+		EIMSK &= ~(1U << pin);
+	}
+	else {
+		EIMSK &= ~(1U << INT6);
+	}
+}
+
+
+/**
+ * @brief Defines the ISRs of every wake-capable pin so each one calls a single handler. Must be used once at 
+ * file scope in the module that arms the wake interrupts.
+ * 
+ * @param handler Function of type void (void) executed from interrupt context on a wake edge.
+ */
+#define BSP_GPIO_WAKE_ISR(handler)								\
+	ISR(PCINT0_vect)											\
+	{															\
+		handler();												\
+	}															\
+	ISR(INT0_vect, ISR_ALIASOF(PCINT0_vect));					\
+	ISR(INT1_vect, ISR_ALIASOF(PCINT0_vect));					\
+	ISR(INT2_vect, ISR_ALIASOF(PCINT0_vect));					\
+	ISR(INT3_vect, ISR_ALIASOF(PCINT0_vect));					\
+	ISR(INT6_vect, ISR_ALIASOF(PCINT0_vect))
+
+
 #endif /* BSP_GPIO_H_ */
@@ -0,0 +1,40 @@
+/**
+ * @file bsp_sleep.h
+ * @author Ian Ress
+ * @brief ATMega16U4 and ATMega32U4 CPU sleep. Only Idle mode is used. It stops the CPU clock but keeps every 
+ * peripheral clocked, so the systick, the USB controller and pin change interrupts all keep running and wake 
+ * the CPU.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef BSP_SLEEP_H_
+#define BSP_SLEEP_H_
+
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+
+/**
+ * @brief Enables interrupts and puts the CPU into Idle mode until an interrupt occurs. Returns after that 
+ * interrupt's ISR has run, with interrupts enabled.
+ * 
+ * @warning Must be called with interrupts disabled. The instruction after sei() always executes before any 
+ * pending interrupt, so an interrupt that arrives after the caller decided to sleep still wakes the CPU 
+ * instead of being missed until the next one.
+ * 
+ */
+static inline void BSP_Sleep_Idle(void);
+static inline void BSP_Sleep_Idle(void)
+{
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+}
+
+#endif /* BSP_SLEEP_H_ */
@@ -0,0 +1,82 @@
+/**
+ * @file bsp_tim1.h
+ * @author Ian Ress
+ * @brief ATMega16U4 and ATMega32U4 direct access to TIM1's counter and TOP value. TIM1 drives the systick, 
+ * which runs it in CTC mode with OCR1A as TOP so the Compare Match A interrupt fires once every tick. The 
+ * systick uses these to stretch a tick over several milliseconds while the CPU sleeps. See Systick_Sleep().
+ * 
+ * TCNT1 and OCR1A are 16-bit registers accessed through the shared TEMP register. avr-gcc emits the high/low 
+ * byte order the hardware requires, but an interrupt that accesses TIM1 in between corrupts TEMP, so these 
+ * must be called with interrupts disabled.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef BSP_TIM1_H_
+#define BSP_TIM1_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <avr/io.h>
+
+
+/**
+ * @brief Returns TIM1's counter. Counts from 0 to TOP then restarts at 0.
+ * 
+ */
+static inline uint16_t BSP_TIM1_Get_Count(void);
+static inline uint16_t BSP_TIM1_Get_Count(void)
+{
+    return TCNT1;
+}
+
+
+/**
+ * @brief Sets TIM1's counter.
+ * 
+ */
+static inline void BSP_TIM1_Set_Count(uint16_t count);
+static inline void BSP_TIM1_Set_Count(uint16_t count)
+{
+    TCNT1 = count;
+}
+
+
+/**
+ * @brief Returns TIM1's TOP value. The counter restarts, and the Compare Match A interrupt fires, every 
+ * TOP + 1 counts.
+ * 
+ */
+static inline uint16_t BSP_TIM1_Get_Top(void);
+static inline uint16_t BSP_TIM1_Get_Top(void)
+{
+    return OCR1A;
+}
+
+
+/**
+ * @brief Sets TIM1's TOP value. If the counter is already past the new TOP it runs on to 0xFFFF and wraps 
+ * before matching, so only raise TOP, or set the counter below the new TOP first.
+ * 
+ */
+static inline void BSP_TIM1_Set_Top(uint16_t top);
+static inline void BSP_TIM1_Set_Top(uint16_t top)
+{
+    OCR1A = top;
+}
+
+
+/**
+ * @brief Returns true if the counter has reached TOP and the Compare Match A interrupt has not run yet.
+ * 
+ */
+static inline bool BSP_TIM1_Compare_Pending(void);
+static inline bool BSP_TIM1_Compare_Pending(void)
+{
+    return (TIFR1 & _BV(OCF1A)) != 0;
+}
+
+#endif /* BSP_TIM1_H_ */
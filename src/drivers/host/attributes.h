@@ -0,0 +1,31 @@
+/**
+ * @file attributes.h
+ * @author Ian Ress
+ * @brief Host stand-in for src/drivers/avr/common/attributes.h. Provides the same GCC attributes without 
+ * requiring AVR GCC, so the Application compiles with the host's GCC or Clang.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef ATTRIBUTES_H
+#define ATTRIBUTES_H
+
+#if defined(__GNUC__)
+    /**
+     * @brief See src/drivers/avr/common/attributes.h.
+     * 
+     */
+    #define GCC_ATTRIBUTE_NAKED                  __attribute__ ((naked))
+    #define GCC_ATTRIBUTE_SECTION(SectionIndex)  __attribute__ ((section (".init" #SectionIndex)))
+    #define GCC_ATTRIBUTE_USED                   __attribute__ ((used))
+    #define GCC_ATTRIBUTE_PACKED                 __attribute__ ((packed))
+    #define GCC_ATTRIBUTE_WEAK                   __attribute__((weak))
+    #define GCC_ATTRIBUTE_WEAK_ALIAS(func)      __attribute__((weak, alias(#func)))
+    #define GCC_ATTRIBUTE_UNUSED                __attribute__((unused))
+#else
+    #error "The host simulation must be compiled with GCC or Clang."
+#endif
+
+#endif /* ATTRIBUTES_H */
@@ -0,0 +1,24 @@
+/**
+ * @file interrupt.h
+ * @author Ian Ress
+ * @brief Host stand-in for avr-libc's <avr/interrupt.h>. ISR() defines a plain function named after the 
+ * vector so a simulation can raise the interrupt by calling it, E.g. PCINT0_vect(). Aliased vectors are only 
+ * declared, so raise the vector they alias instead.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#include "host_io.h"
+
+#define ISR(vector, ...)                        void vector(void)
+#define ISR_ALIASOF(vector)
+
+#define sei()                                   Host_Interrupts_Restore(true)
+#define cli()                                   ((void)Host_Interrupts_Disable())
+
+#endif /* HOST_AVR_INTERRUPT_H */
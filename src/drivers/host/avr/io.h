@@ -0,0 +1,40 @@
+/**
+ * @file io.h
+ * @author Ian Ress
+ * @brief Host stand-in for avr-libc's <avr/io.h>. Maps the ATMega16U4/ATMega32U4 register names used by the 
+ * Application onto the mock register file. Only registers the Application uses are listed. Add any others 
+ * here with their data-space address from the datasheet.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+#include "host_io.h"
+
+#define _BV(bit)                                (1U << (bit))
+
+/* External Interrupts */
+#define PCIFR                                   BSP_IO_REGISTER(0x3B)
+#define EIFR                                    BSP_IO_REGISTER(0x3C)
+#define EIMSK                                   BSP_IO_REGISTER(0x3D)
+#define PCICR                                   BSP_IO_REGISTER(0x68)
+#define EICRA                                   BSP_IO_REGISTER(0x69)
+#define EICRB                                   BSP_IO_REGISTER(0x6A)
+#define PCMSK0                                  BSP_IO_REGISTER(0x6B)
+
+#define PCIF0                                   0
+#define PCIE0                                   0
+#define INTF6                                   6
+#define INT6                                    6
+#define ISC60                                   4
+
+/* System Control */
+#define SMCR                                    BSP_IO_REGISTER(0x53)
+#define MCUCR                                   BSP_IO_REGISTER(0x55)
+
+#endif /* HOST_AVR_IO_H */
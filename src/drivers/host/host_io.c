@@ -0,0 +1,97 @@
+/**
+ * @file host_io.c
+ * @author Ian Ress
+ * @brief Mock AVR I/O Register file for running the Application on a Linux host. See host_io.h.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include <stddef.h>
+#include "host_io.h"
+#include "host_systick.h"
+
+volatile uint8_t g_host_io_registers[HOST_IO_REGISTER_COUNT];
+volatile bool g_host_interrupts_enabled = false;
+
+static Host_IO_Hook_t io_hook = NULL;
+
+
+/**
+ * @brief Clears every register, removes the hook and disables interrupts. Equivalent to a Power-on Reset.
+ * 
+ */
+void Host_IO_Reset(void)
+{
+    for (uint16_t i = 0; i < HOST_IO_REGISTER_COUNT; i++)
+    {
+        g_host_io_registers[i] = 0;
+    }
+    io_hook = NULL;
+    g_host_interrupts_enabled = false;
+}
+
+
+/**
+ * @brief Installs the function called before every register access.
+ * 
+ * @param hook The hook. NULL removes the current hook.
+ * 
+ */
+void Host_IO_Set_Hook(Host_IO_Hook_t hook)
+{
+    io_hook = hook;
+}
+
+
+/**
+ * @brief Returns the mock register at @p address after running the hook. Never call directly - used through 
+ * BSP_IO_REGISTER() and the register names defined in avr/io.h.
+ * 
+ * @param address Register address as listed in the ATMega16U4/ATMega32U4 datasheet.
+ * 
+ * @return Pointer to the mock register. Addresses outside the register file wrap around.
+ * 
+ */
+volatile uint8_t * Host_IO_Register(uint16_t address)
+{
+    address &= (HOST_IO_REGISTER_COUNT - 1U);
+
+    if (io_hook != NULL)
+    {
+        io_hook(address);
+    }
+    return &g_host_io_registers[address];
+}
+
+
+/**
+ * @brief Clears the simulated Global Interrupt Flag.
+ * 
+ * @return The previous state of the flag.
+ * 
+ */
+bool Host_Interrupts_Disable(void)
+{
+    bool enabled = g_host_interrupts_enabled;
+    g_host_interrupts_enabled = false;
+    return enabled;
+}
+
+
+/**
+ * @brief Sets the simulated Global Interrupt Flag. Any interrupt latched while it was cleared runs now.
+ * 
+ * @param enabled The new state of the flag.
+ * 
+ */
+void Host_Interrupts_Restore(bool enabled)
+{
+    g_host_interrupts_enabled = enabled;
+
+    if (enabled)
+    {
+        Host_Systick_Service(); /* Run the systick interrupt if it fired while interrupts were disabled. */
+    }
+}
@@ -0,0 +1,78 @@
+/**
+ * @file host_io.h
+ * @author Ian Ress
+ * @brief Mock AVR I/O Register file for running the Application on a Linux host. The host driver folder 
+ * replaces the target driver folders on the include path and stands in for the avr-libc headers the 
+ * Application includes:
+ * 
+ * 
+ *      avr/io.h          Register names mapped onto the mock register file.
+ *      avr/interrupt.h   ISR() declares a plain function. sei()/cli() set the simulated Global Interrupt Flag.
+ *      util/atomic.h     ATOMIC_BLOCK() clears and restores the simulated Global Interrupt Flag.
+ *      util/delay.h      _delay_us()/_delay_ms() advance the simulated clock. See host_systick.h.
+ *      attributes.h      GCC attributes without the AVR GCC requirement.
+ * 
+ * 
+ * The target's own bsp_gpio.h and kb_pin_def.h are still used so the GPIO code under test is the code that 
+ * ships. Every access they make goes through BSP_IO_REGISTER(), which is redirected here to Host_IO_Register(). 
+ * The host target in the top-level CMakeLists.txt builds the Application's portable modules this way 
+ * along with the checks in tests/:
+ * 
+ * 
+ *      cmake -S . -B build && cmake --build build && ctest --test-dir build
+ * 
+ * 
+ * The USB HID Device Hsm in usb_hid_device_hsm.c is not part of it yet since it still has #error TODOs. 
+ * See the top-level CMakeLists.txt.
+ * 
+ * Note that src/drivers/avr/common must NOT be on the include path since its attributes.h rejects non-AVR 
+ * compilers.
+ * 
+ * A simulation (E.g. a model of the Keyboard PCB) installs a hook with Host_IO_Set_Hook(). The hook runs 
+ * before every register access with the address being accessed, so input registers can be computed 
+ * lazily. For example a PINx read can be derived from the current PORTx/DDRx values and the keys being 
+ * held. Writes land in the register file after the hook returns, so they are seen by the next access.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef HOST_IO_H
+#define HOST_IO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Size of the mock register file. Covers the whole I/O and Extended I/O space of ATMega16U4/ATMega32U4 
+ * (0x20 - 0xFF) so register addresses are used as indices as is.
+ * 
+ */
+#define HOST_IO_REGISTER_COUNT                  0x100U
+
+/**
+ * @brief Redirects every BSP register access to the mock register file. See bsp_gpio.h.
+ * 
+ */
+#define BSP_IO_REGISTER(address)                (*Host_IO_Register(address))
+
+/**
+ * @brief Called before every access to the mock register file.
+ * 
+ * @param address The register address about to be accessed.
+ * 
+ */
+typedef void (*Host_IO_Hook_t)(uint16_t address);
+
+extern volatile uint8_t g_host_io_registers[HOST_IO_REGISTER_COUNT];
+extern volatile bool g_host_interrupts_enabled;
+
+void Host_IO_Reset(void);
+void Host_IO_Set_Hook(Host_IO_Hook_t hook);
+volatile uint8_t * Host_IO_Register(uint16_t address);
+bool Host_Interrupts_Disable(void);
+void Host_Interrupts_Restore(bool enabled);
+
+#endif /* HOST_IO_H */
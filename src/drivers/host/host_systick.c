@@ -0,0 +1,204 @@
+/**
+ * @file host_systick.c
+ * @author Ian Ress
+ * @brief Simulated clock for running the Application on a Linux host. See host_systick.h.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "host_io.h"
+#include "host_systick.h"
+
+volatile systick_wordsize_t g_ms = 0;
+volatile systick_wordsize_t g_ms_epoch = 0;
+volatile bool g_ms_stretched = false;               /* Never set. Systick_Sleep() advances whole ticks instead of stretching one. */
+
+static uint64_t clock_us = 0;                   /* Simulated time since Host_Systick_Reset(). Always runs. */
+static uint32_t tick_us = 0;                    /* Time since the last systick interrupt. */
+static bool running = false;                    /* True between Systick_Start() and Systick_Stop(). */
+static bool pending = false;                    /* Interrupt flag latched while interrupts were disabled. */
+static Host_Systick_Hook_t tick_hook = NULL;
+
+
+/**
+ * @brief Simulated systick interrupt.
+ * 
+ */
+static void Systick_ISR(void);
+static void Systick_ISR(void)
+{
+    g_ms++;
+
+    if (g_ms == 0)
+    {
+        g_ms_epoch++;
+    }
+
+    if (tick_hook != NULL)
+    {
+        tick_hook();
+    }
+}
+
+
+/**
+ * @brief Stops the systick, removes the hook and sets the simulated time and g_ms back to 0.
+ * 
+ */
+void Host_Systick_Reset(void)
+{
+    g_ms = 0;
+    g_ms_epoch = 0;
+    clock_us = 0;
+    tick_us = 0;
+    running = false;
+    pending = false;
+    tick_hook = NULL;
+}
+
+
+/**
+ * @brief Installs the function called after every systick interrupt.
+ * 
+ * @param hook The hook. NULL removes the current hook.
+ * 
+ */
+void Host_Systick_Set_Hook(Host_Systick_Hook_t hook)
+{
+    tick_hook = hook;
+}
+
+
+/**
+ * @brief Advances simulated time. Runs one systick interrupt for every SYSTICK_PERIOD_MS crossed while the 
+ * systick is started.
+ * 
+ * @param us Microseconds to advance.
+ * 
+ */
+void Host_Systick_Advance_Us(uint32_t us)
+{
+    while (us)
+    {
+        uint32_t step = (uint32_t)(SYSTICK_PERIOD_MS * 1000U) - tick_us;
+
+        if (step > us)
+        {
+            step = us;
+        }
+
+        us -= step;
+        clock_us += step;
+        tick_us += step;
+
+        if (tick_us >= (uint32_t)(SYSTICK_PERIOD_MS * 1000U))
+        {
+            tick_us = 0;
+
+            if (running)
+            {
+                pending = true;
+                Host_Systick_Service();
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Runs the systick interrupt if its flag is latched and interrupts are enabled. Like the hardware flag, 
+ * only one interrupt is latched no matter how many ticks pass while interrupts are disabled. Called when 
+ * interrupts are re-enabled.
+ * 
+ */
+void Host_Systick_Service(void)
+{
+    if (pending && g_host_interrupts_enabled)
+    {
+        pending = false;
+        Systick_ISR();
+    }
+}
+
+
+/**
+ * @brief Returns simulated time.
+ * 
+ * @return Microseconds since Host_Systick_Reset().
+ * 
+ */
+uint64_t Host_Systick_Now_Us(void)
+{
+    return clock_us;
+}
+
+
+/**
+ * @brief Initializes the systick. Nothing to configure on the host.
+ * 
+ */
+void Systick_Init(void)
+{
+    tick_us = 0;
+}
+
+
+/**
+ * @brief Starts the systick.
+ * 
+ */
+void Systick_Start(void)
+{
+    running = true;
+}
+
+
+/**
+ * @brief Stops the systick.
+ * 
+ */
+void Systick_Stop(void)
+{
+    running = false;
+}
+
+
+/**
+ * @brief Sleeps until @p ms milliseconds of ticks have passed by advancing simulated time straight to the 
+ * end of the sleep. A tick hook stands in for the other interrupts that can wake the CPU, so while one is 
+ * installed the sleep ends at the next tick instead.
+ * 
+ * @param ms How long to sleep. 0 or 1 sleeps until the next tick.
+ * 
+ * @warning Must be called with interrupts disabled. Returns with interrupts enabled.
+ * 
+ */
+void Systick_Sleep(systick_wordsize_t ms)
+{
+    uint32_t ticks = (uint32_t)(ms / SYSTICK_PERIOD_MS);
+
+    if ((ticks == 0U) || (tick_hook != NULL))
+    {
+        ticks = 1U;
+    }
+
+    Host_Interrupts_Restore(true);
+    Host_Systick_Advance_Us((ticks * SYSTICK_PERIOD_MS * 1000U) - tick_us);
+}
+
+
+/**
+ * @brief Reads the current simulated time with microsecond resolution.
+ * 
+ * @param time Where the current time is stored.
+ * 
+ */
+void Systick_Get_Time(Systick_Time_t * const time)
+{
+    time->ms = Systick_Get_Ms32();
+    time->ns = tick_us * 1000UL;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file host_systick.h
+ * @author Ian Ress
+ * @brief Simulated clock for running the Application on a Linux host. Implements the systick.h API so g_ms 
+ * advances only when the simulation advances time, which makes every run repeatable. The clock has 
+ * microsecond resolution so busy-waits such as _delay_us() consume simulated time too.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef HOST_SYSTICK_H
+#define HOST_SYSTICK_H
+
+#include <stdint.h>
+#include "systick.h"
+
+/**
+ * @brief Called from the simulated systick interrupt after g_ms increments. E.g. to run other simulated 
+ * peripherals in lockstep with the clock.
+ * 
+ */
+typedef void (*Host_Systick_Hook_t)(void);
+
+void Host_Systick_Reset(void);
+void Host_Systick_Set_Hook(Host_Systick_Hook_t hook);
+void Host_Systick_Advance_Us(uint32_t us);
+void Host_Systick_Service(void);
+uint64_t Host_Systick_Now_Us(void);
+
+#endif /* HOST_SYSTICK_H */
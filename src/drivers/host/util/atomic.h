@@ -0,0 +1,27 @@
+/**
+ * @file atomic.h
+ * @author Ian Ress
+ * @brief Host stand-in for avr-libc's <util/atomic.h>. The host build is single-threaded so ATOMIC_BLOCK() 
+ * only clears the simulated Global Interrupt Flag for its body. Simulated interrupts latched in the 
+ * meantime run when the flag is set again. See host_io.h.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+#include <stdbool.h>
+#include "host_io.h"
+
+#define ATOMIC_RESTORESTATE                     0
+#define ATOMIC_FORCEON                          1
+
+#define ATOMIC_BLOCK(type)                                                                              \
+    for (bool host_atomic_sreg = Host_Interrupts_Disable(), host_atomic_once = true;                    \
+         host_atomic_once;                                                                              \
+         host_atomic_once = false, Host_Interrupts_Restore((type) ? true : host_atomic_sreg))
+
+#endif /* HOST_UTIL_ATOMIC_H */
@@ -0,0 +1,20 @@
+/**
+ * @file delay.h
+ * @author Ian Ress
+ * @brief Host stand-in for avr-libc's <util/delay.h>. Busy-waits advance the simulated clock instead of 
+ * burning host time. See host_systick.h.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef HOST_UTIL_DELAY_H
+#define HOST_UTIL_DELAY_H
+
+#include "host_systick.h"
+
+#define _delay_us(us)                           Host_Systick_Advance_Us((uint32_t)(us))
+#define _delay_ms(ms)                           Host_Systick_Advance_Us((uint32_t)(ms) * 1000U)
+
+#endif /* HOST_UTIL_DELAY_H */
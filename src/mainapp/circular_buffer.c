@@ -1,64 +1,248 @@
 /**
  * @file circular_buffer.c
  * @author Ian Ress
- * @brief Circular buffer for USB buffer.
+ * @brief Single-producer/single-consumer circular buffer of fixed-size elements. See 
+ * circular_buffer.h.
+ * 
+ * Indices are published with GCC's __atomic builtins. On AVR a byte load/store is already 
+ * atomic, so these compile to a plain lds/sts that the compiler cannot reorder with the element 
+ * copy. On the host they also order the accesses between CPU cores.
  * @date 2023-02-15
  * 
  * @copyright Copyright (c) 2023
  * 
  */
 
+#include <string.h>
 #include "circular_buffer.h"
 
 /**
- * @brief Writes data to the circular buffer if there's space. Increments the head accordingly.
+ * @brief Wraps a free-running index into the buffer.
+ * 
+ */
+#define CIRCBUF_INDEX(cb, i)                    ((uint8_t)((i) & ((cb)->size - 1U)))
+
+#define CIRCBUF_LOAD_ACQUIRE(index)             __atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#define CIRCBUF_STORE_RELEASE(index, value)     __atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+
+/**
+ * @brief Splits @p count elements starting at free-running index @p start into the part before the end 
+ * of the storage and the part that wraps to the beginning.
  * 
  * @param cb pointer to circbuf_t struct.
- * @param data the data to write.
+ * @param start free-running index of the first element.
+ * @param count number of elements. At most cb->size.
+ * @param spans where the two spans are stored. The second has a count of 0 if nothing wraps.
+ * 
+ */
+static void circbuf_spans(const circbuf_t * const cb, uint8_t start, uint8_t count, circbuf_span_t spans[2]);
+static void circbuf_spans(const circbuf_t * const cb, uint8_t start, uint8_t count, circbuf_span_t spans[2]) {
+    const uint8_t first = CIRCBUF_INDEX(cb, start);
+    const uint8_t before_end = (uint8_t)(cb->size - first);
+
+    spans[0].data = &cb->buf[first * cb->elemsize];
+    spans[0].count = (count < before_end) ? count : before_end;
+    spans[1].data = cb->buf;
+    spans[1].count = (uint8_t)(count - spans[0].count);
+}
+
+/**
+ * @brief Empties the buffer. Must be called before the producer and consumer start.
  * 
- * @return 0 if the write failed (buffer full). 0 if write successful.
+ * @param cb pointer to circbuf_t struct.
  * 
  */
-uint8_t circbuf_write(circbuf_t * const cb, uint8_t data) {
-    uint16_t next;
-    next = cb->head + 1;
+void circbuf_init(circbuf_t * const cb) {
+    cb->head = 0;
+    cb->tail = 0;
+}
 
-    if (next >= cb->maxlen) {
-        next = 0;
-    }
+/**
+ * @brief Writes one element to the circular buffer if there's space. Increments the head accordingly. 
+ * Only call from the producer.
+ * 
+ * @param cb pointer to circbuf_t struct.
+ * @param data the element to write. cb->elemsize bytes are copied.
+ * 
+ * @return 0 if the write failed (buffer full). 1 if write successful.
+ * 
+ */
+uint8_t circbuf_write(circbuf_t * const cb, const void * const data) {
+    const uint8_t head = cb->head;
+    const uint8_t * src = (const uint8_t *)data;
+    uint8_t * dst;
 
-    if (next == cb->tail) { /* Buffer full. Don't overwrite data. */
+    if ((uint8_t)(head - CIRCBUF_LOAD_ACQUIRE(cb->tail)) >= cb->size) { /* Buffer full. Don't overwrite data. */
         return 0;
     }
 
-    cb->buf[cb->head] = data;
-    cb->head = next;
+    dst = &cb->buf[CIRCBUF_INDEX(cb, head) * cb->elemsize];
+    for (uint8_t i = 0; i < cb->elemsize; i++) {
+        dst[i] = src[i];
+    }
+
+    CIRCBUF_STORE_RELEASE(cb->head, (uint8_t)(head + 1U));
     return 1;
 }
 
 /**
- * @brief Reads data to the circular buffer if there's data available. 
- * Increments the tail accordingly.
+ * @brief Reads one element from the circular buffer if there's data available. 
+ * Increments the tail accordingly. Only call from the consumer.
  * 
  * @param cb pointer to circbuf_t struct.
- * @param data the data to read.
+ * @param data where the element is copied to. cb->elemsize bytes are written.
  * 
  * @return 0 if the buffer is empty. 1 on successful read.
  * 
  */
-uint8_t circbuf_read(circbuf_t * const cb, uint8_t * data) {
-    uint16_t next;
+uint8_t circbuf_read(circbuf_t * const cb, void * const data) {
+    const uint8_t tail = cb->tail;
+    const uint8_t * src;
+    uint8_t * dst = (uint8_t *)data;
 
-    if (cb->head == cb->tail) { /* Buffer empty. */
+    if (tail == CIRCBUF_LOAD_ACQUIRE(cb->head)) { /* Buffer empty. */
         return 0;
     }
 
-    next = cb->tail + 1;
-    if (next >= cb->maxlen) {
-        next = 0;
+    src = &cb->buf[CIRCBUF_INDEX(cb, tail) * cb->elemsize];
+    for (uint8_t i = 0; i < cb->elemsize; i++) {
+        dst[i] = src[i];
     }
 
-    *data = cb->buf[cb->tail];
-    cb->tail = next;
+    CIRCBUF_STORE_RELEASE(cb->tail, (uint8_t)(tail + 1U));
     return 1;
 }
+
+/**
+ * @brief Returns the number of elements in the buffer. Either side may call this. The other side 
+ * can change the count straight after, but only in the safe direction: the producer may see more 
+ * elements than there are and the consumer fewer, never the other way around.
+ * 
+ * @param cb pointer to circbuf_t struct.
+ * 
+ */
+uint8_t circbuf_count(const circbuf_t * const cb) {
+    return (uint8_t)(CIRCBUF_LOAD_ACQUIRE(cb->head) - CIRCBUF_LOAD_ACQUIRE(cb->tail));
+}
+
+/**
+ * @brief Writes up to @p count elements to the circular buffer, as many as there's space for. The head 
+ * is published once for the whole write. Only call from the producer.
+ * 
+ * @param cb pointer to circbuf_t struct.
+ * @param data the elements to write. Stored back to back.
+ * @param count number of elements to write.
+ * 
+ * @return the number of elements written. Less than @p count if the buffer filled up.
+ * 
+ */
+uint8_t circbuf_write_bulk(circbuf_t * const cb, const void * const data, uint8_t count) {
+    circbuf_span_t spans[2];
+    const uint8_t space = circbuf_peek_writable(cb, spans);
+    const uint8_t * src = (const uint8_t *)data;
+
+    if (count > space) {
+        count = space;
+    }
+    if (spans[0].count > count) {
+        spans[0].count = count;
+    }
+    spans[1].count = (uint8_t)(count - spans[0].count);
+
+    memcpy(spans[0].data, src, (size_t)spans[0].count * cb->elemsize);
+    memcpy(spans[1].data, &src[(size_t)spans[0].count * cb->elemsize], (size_t)spans[1].count * cb->elemsize);
+
+    circbuf_commit_write(cb, count);
+    return count;
+}
+
+/**
+ * @brief Reads up to @p count elements from the circular buffer, as many as are available. The tail 
+ * is published once for the whole read. Only call from the consumer.
+ * 
+ * @param cb pointer to circbuf_t struct.
+ * @param data where the elements are copied to. Stored back to back.
+ * @param count maximum number of elements to read.
+ * 
+ * @return the number of elements read. 0 if the buffer is empty.
+ * 
+ */
+uint8_t circbuf_read_bulk(circbuf_t * const cb, void * const data, uint8_t count) {
+    circbuf_span_t spans[2];
+    const uint8_t used = circbuf_peek_readable(cb, spans);
+    uint8_t * dst = (uint8_t *)data;
+
+    if (count > used) {
+        count = used;
+    }
+    if (spans[0].count > count) {
+        spans[0].count = count;
+    }
+    spans[1].count = (uint8_t)(count - spans[0].count);
+
+    memcpy(dst, spans[0].data, (size_t)spans[0].count * cb->elemsize);
+    memcpy(&dst[(size_t)spans[0].count * cb->elemsize], spans[1].data, (size_t)spans[1].count * cb->elemsize);
+
+    circbuf_commit_read(cb, count);
+    return count;
+}
+
+/**
+ * @brief Hands out the free slots of the circular buffer so the producer can fill them in place. 
+ * Nothing is published until circbuf_commit_write(). Only call from the producer.
+ * 
+ * @param cb pointer to circbuf_t struct.
+ * @param spans where the free slots are stored, in the order they will be read. Up to two spans.
+ * 
+ * @return the total number of free slots across both spans.
+ * 
+ */
+uint8_t circbuf_peek_writable(circbuf_t * const cb, circbuf_span_t spans[2]) {
+    const uint8_t head = cb->head;
+    const uint8_t space = (uint8_t)(cb->size - (uint8_t)(head - CIRCBUF_LOAD_ACQUIRE(cb->tail)));
+
+    circbuf_spans(cb, head, space, spans);
+    return space;
+}
+
+/**
+ * @brief Publishes slots filled in place after circbuf_peek_writable(). Only call from the producer.
+ * 
+ * @param cb pointer to circbuf_t struct.
+ * @param count number of slots filled, starting from the first span. At most the number returned 
+ * by circbuf_peek_writable().
+ * 
+ */
+void circbuf_commit_write(circbuf_t * const cb, uint8_t count) {
+    CIRCBUF_STORE_RELEASE(cb->head, (uint8_t)(cb->head + count));
+}
+
+/**
+ * @brief Hands out the stored elements of the circular buffer so the consumer can use them in place. 
+ * Nothing is freed until circbuf_commit_read(). Only call from the consumer.
+ * 
+ * @param cb pointer to circbuf_t struct.
+ * @param spans where the stored elements are stored, oldest first. Up to two spans.
+ * 
+ * @return the total number of elements across both spans.
+ * 
+ */
+uint8_t circbuf_peek_readable(circbuf_t * const cb, circbuf_span_t spans[2]) {
+    const uint8_t tail = cb->tail;
+    const uint8_t used = (uint8_t)(CIRCBUF_LOAD_ACQUIRE(cb->head) - tail);
+
+    circbuf_spans(cb, tail, used, spans);
+    return used;
+}
+
+/**
+ * @brief Frees elements used in place after circbuf_peek_readable(). Only call from the consumer.
+ * 
+ * @param cb pointer to circbuf_t struct.
+ * @param count number of elements used, starting from the oldest. At most the number returned by 
+ * circbuf_peek_readable().
+ * 
+ */
+void circbuf_commit_read(circbuf_t * const cb, uint8_t count) {
+    CIRCBUF_STORE_RELEASE(cb->tail, (uint8_t)(cb->tail + count));
+}
@@ -1,7 +1,32 @@
 /**
  * @file circular_buffer.h
  * @author Ian Ress
- * @brief Circular buffer for USB buffer.
+ * @brief Single-producer/single-consumer circular buffer of fixed-size elements. One side may 
+ * be an ISR and neither side disables interrupts. The capacity is a power of two so the 
+ * free-running head and tail indices wrap with a mask. The head is only written by the producer 
+ * and the tail only by the consumer. Each is a single byte, so reading or writing one is atomic, 
+ * and each is published with release ordering after the element it hands over.
+ * 
+ * Define buffers with CIRCBUF_DEFINE(), E.g. a buffer of 16 Key_Event_t:
+ * 
+ * 
+ *      CIRCBUF_DEFINE(static, key_events, Key_Event_t, 16);
+ * 
+ * 
+ * Besides one element at a time, elements can be copied in bulk, or accessed in place with no copy 
+ * at all. circbuf_peek_readable() hands out the stored elements as up to two contiguous spans 
+ * (two when they wrap past the end of the storage). The consumer uses them directly, E.g. writing 
+ * them straight into a USB endpoint FIFO, then hands the slots back with circbuf_commit_read(). 
+ * Writing works the same way with circbuf_peek_writable() and circbuf_commit_write().
+ * 
+ * 
+ *      circbuf_span_t spans[2];
+ *      uint8_t n = circbuf_peek_readable(&cb, spans);
+ *      Endpoint_Write_Stream_LE(spans[0].data, spans[0].count * cb.elemsize, NULL);
+ *      Endpoint_Write_Stream_LE(spans[1].data, spans[1].count * cb.elemsize, NULL);
+ *      circbuf_commit_read(&cb, n);
+ * 
+ * 
  * @date 2023-02-15
  * 
  * @copyright Copyright (c) 2023
@@ -14,13 +39,45 @@
 #include <stdint.h>
 
 typedef struct {
-    uint8_t * const buf;
-    uint8_t head; /* write */
-    uint8_t tail; /* read */
-    const uint8_t maxlen; 
+    uint8_t * const buf;        /* Storage for size * elemsize bytes. */
+    volatile uint8_t head;      /* write. Free-running. Only written by the producer. */
+    volatile uint8_t tail;      /* read. Free-running. Only written by the consumer. */
+    const uint8_t size;         /* Capacity in elements. Power of two between 2 and 128 inclusive. */
+    const uint8_t elemsize;     /* Size of one element in bytes. */
 } circbuf_t;
 
-uint8_t circbuf_write(circbuf_t * const cb, uint8_t data);
-uint8_t circbuf_read(circbuf_t * const cb, uint8_t * data);
+/**
+ * @brief Contiguous run of elements inside a circular buffer's storage. See circbuf_peek_readable().
+ * 
+ */
+typedef struct {
+    uint8_t * data;             /* First element. */
+    uint8_t count;              /* Number of elements. 0 if the span is unused. */
+} circbuf_span_t;
+
+/**
+ * @brief Defines a circular buffer @p name holding @p count elements of @p type, along with its storage. 
+ * A compilation error occurs if @p count is not a power of two between 2 and 128 inclusive. The 
+ * storage is an array of @p type, so it is aligned for @p type and span data can be cast back to it.
+ * 
+ * @param storage Storage class of the buffer. E.g. static, or empty for a global.
+ * 
+ */
+#define CIRCBUF_DEFINE(storage, name, type, count)                                                          \
+    typedef char name##_count_must_be_a_power_of_two_between_2_and_128                                      \
+        [((((count) & ((count) - 1)) == 0) && ((count) >= 2) && ((count) <= 128)) ? 1 : -1];                \
+    static type name##_storage[count];                                                                      \
+    storage circbuf_t name = {(uint8_t *)name##_storage, 0, 0, (uint8_t)(count), (uint8_t)sizeof(type)}
+
+void circbuf_init(circbuf_t * const cb);
+uint8_t circbuf_write(circbuf_t * const cb, const void * const data);
+uint8_t circbuf_read(circbuf_t * const cb, void * const data);
+uint8_t circbuf_count(const circbuf_t * const cb);
+uint8_t circbuf_write_bulk(circbuf_t * const cb, const void * const data, uint8_t count);
+uint8_t circbuf_read_bulk(circbuf_t * const cb, void * const data, uint8_t count);
+uint8_t circbuf_peek_writable(circbuf_t * const cb, circbuf_span_t spans[2]);
+void circbuf_commit_write(circbuf_t * const cb, uint8_t count);
+uint8_t circbuf_peek_readable(circbuf_t * const cb, circbuf_span_t spans[2]);
+void circbuf_commit_read(circbuf_t * const cb, uint8_t count);
 
 #endif /* CIRCBUF_H */
@@ -318,12 +318,92 @@
 
 
 
+        /**
+         * Keyboard Programming Configuration checks.
+         */
+        #if ( ((KB_ENABLE_JTAG) != 0) && ((KB_ENABLE_JTAG) != 1) )
+            #error "KB_ENABLE_JTAG must be set to either 0 or 1. Fix in kb_programming_config.h"
+        #endif
+        #if ( ((KB_ENABLE_SWD) != 0) && ((KB_ENABLE_SWD) != 1) )
+            #error "KB_ENABLE_SWD must be set to either 0 or 1. Fix in kb_programming_config.h"
+        #endif
+        #if ( ((KB_ENABLE_PDI) != 0) && ((KB_ENABLE_PDI) != 1) )
+            #error "KB_ENABLE_PDI must be set to either 0 or 1. Fix in kb_programming_config.h"
+        #endif
+
+
+
         /**
          * Keyboard Configuration checks.
          */
         #if ((KB_NUMBER_OF_COLUMNS + KB_NUMBER_OF_ROWS) > NUMBER_OF_IO_PINS)
             #error "Target does not have enough I/O pins to support keyboard configuration in kb_config.h"
         #endif
+        #if ( ((KB_NUMBER_OF_ROWS) <= 0) || ((KB_NUMBER_OF_COLUMNS) <= 0) )
+            #error "KB_NUMBER_OF_ROWS and KB_NUMBER_OF_COLUMNS must be greater than 0. Fix in kb_config.h"
+        #endif
+        #if ( ((KB_MATRIX_STROBE_ROWS) == 1) && ((KB_NUMBER_OF_COLUMNS) > 32) )
+            #error "KB_NUMBER_OF_COLUMNS must be 32 or less when the Rows are strobed. Fix in kb_config.h"
+        #endif
+        #if ( ((KB_MATRIX_STROBE_ROWS) == 0) && ((KB_NUMBER_OF_ROWS) > 32) )
+            #error "KB_NUMBER_OF_ROWS must be 32 or less when the Columns are strobed. Fix in kb_config.h"
+        #endif
+        #if ( ((KB_DIODE_DIRECTION) != COL2ROW) && ((KB_DIODE_DIRECTION) != ROW2COL) )
+            #error "KB_DIODE_DIRECTION must be set to either COL2ROW or ROW2COL. Fix in kb_config.h"
+        #endif
+        #if ( ((KB_MATRIX_AUTO_STROBE_ORIENTATION) != 0) && ((KB_MATRIX_AUTO_STROBE_ORIENTATION) != 1) )
+            #error "KB_MATRIX_AUTO_STROBE_ORIENTATION must be set to either 0 or 1. Fix in kb_config.h"
+        #endif
+        #if ((KB_MATRIX_AUTO_STROBE_ORIENTATION) == 0)
+            #if ( ((KB_SET_COLUMNS_AS_INPUTS_OR_OUTPUTS) != 0) && ((KB_SET_COLUMNS_AS_INPUTS_OR_OUTPUTS) != 1) )
+                #error "KB_SET_COLUMNS_AS_INPUTS_OR_OUTPUTS must be set to either 0 or 1. Fix in kb_config.h"
+            #endif
+            #if ( (KB_SET_COLUMNS_AS_INPUTS_OR_OUTPUTS) == (KB_SET_ROWS_AS_OUTPUTS) )
+                #error "Only one of KB_SET_COLUMNS_AS_INPUTS_OR_OUTPUTS or KB_SET_ROWS_AS_OUTPUTS can be set to 1. Fix in kb_config.h"
+            #endif
+            #if ( ((KB_KEYPRESS_DETECTION_LEVEL) != KB_PIN_HIGH) && ((KB_KEYPRESS_DETECTION_LEVEL) != KB_PIN_LOW) )
+                #error "KB_KEYPRESS_DETECTION_LEVEL must be set to either KB_PIN_HIGH or KB_PIN_LOW. Fix in kb_config.h"
+            #endif
+            #if ( (((KB_SET_ROWS_AS_OUTPUTS) == 1) == ((KB_DIODE_DIRECTION) == COL2ROW)) != ((KB_KEYPRESS_DETECTION_LEVEL) == KB_PIN_LOW) )
+                #error "KB_DIODE_DIRECTION blocks the strobe with this orientation and KB_KEYPRESS_DETECTION_LEVEL. Flip one of them or set KB_MATRIX_AUTO_STROBE_ORIENTATION to 1. Fix in kb_config.h"
+            #endif
+        #endif
+        #if ( ((KB_DEBOUNCE_ALGORITHM) != KB_DEBOUNCE_DEFERRED) && ((KB_DEBOUNCE_ALGORITHM) != KB_DEBOUNCE_VERTICAL_COUNTER) && \
+              ((KB_DEBOUNCE_ALGORITHM) != KB_DEBOUNCE_EAGER) && ((KB_DEBOUNCE_ALGORITHM) != KB_DEBOUNCE_ASYMMETRIC) )
+            #error "KB_DEBOUNCE_ALGORITHM must be set to KB_DEBOUNCE_DEFERRED, KB_DEBOUNCE_EAGER, KB_DEBOUNCE_ASYMMETRIC or KB_DEBOUNCE_VERTICAL_COUNTER. Fix in kb_config.h"
+        #endif
+        #if ((KB_DEBOUNCE_ALGORITHM) == KB_DEBOUNCE_ASYMMETRIC)
+            #if ( ((KB_DEBOUNCE_PRESS_TIME_MS) < 0) || ((KB_DEBOUNCE_RELEASE_TIME_MS) < 0) )
+                #error "KB_DEBOUNCE_PRESS_TIME_MS and KB_DEBOUNCE_RELEASE_TIME_MS cannot be negative. Fix in kb_config.h"
+            #endif
+        #endif
+        #if ( ((KB_DEBOUNCE_MAX_BOUNCING_KEYS) < 1) || ((KB_DEBOUNCE_MAX_BOUNCING_KEYS) > 254) )
+            #error "KB_DEBOUNCE_MAX_BOUNCING_KEYS must be between 1 and 254 inclusive. Fix in kb_config.h"
+        #endif
+        #if ( ((KB_KEY_EVENT_QUEUE_SIZE) < 2) || ((KB_KEY_EVENT_QUEUE_SIZE) > 128) || (((KB_KEY_EVENT_QUEUE_SIZE) & ((KB_KEY_EVENT_QUEUE_SIZE) - 1)) != 0) )
+            #error "KB_KEY_EVENT_QUEUE_SIZE must be a power of two between 2 and 128 inclusive. Fix in kb_config.h"
+        #endif
+        #if ( ((KB_MATRIX_PORT_WIDE_SAMPLING) != 0) && ((KB_MATRIX_PORT_WIDE_SAMPLING) != 1) )
+            #error "KB_MATRIX_PORT_WIDE_SAMPLING must be set to either 0 or 1. Fix in kb_config.h"
+        #endif
+        #if ((KB_MATRIX_SETTLE_US) < 0)
+            #error "KB_MATRIX_SETTLE_US cannot be negative. Fix in kb_config.h"
+        #endif
+        #if ( ((KB_MATRIX_UNROLLED_SCAN) != 0) && ((KB_MATRIX_UNROLLED_SCAN) != 1) )
+            #error "KB_MATRIX_UNROLLED_SCAN must be set to either 0 or 1. Fix in kb_config.h"
+        #endif
+        #if ( ((KB_MATRIX_UNROLLED_SCAN) == 1) && (((KB_NUMBER_OF_ROWS) > 32) || ((KB_NUMBER_OF_COLUMNS) > 32)) )
+            #error "KB_NUMBER_OF_ROWS and KB_NUMBER_OF_COLUMNS cannot exceed 32 when KB_MATRIX_UNROLLED_SCAN is set to 1. Fix in kb_config.h"
+        #endif
+        #if ( ((KB_MATRIX_SCAN_PERIOD_MIN_MS) < 1) || ((KB_MATRIX_SCAN_PERIOD_MAX_MS) < (KB_MATRIX_SCAN_PERIOD_MIN_MS)) )
+            #error "KB_MATRIX_SCAN_PERIOD_MIN_MS must be at least 1 and KB_MATRIX_SCAN_PERIOD_MAX_MS cannot be less than it. Fix in kb_config.h"
+        #endif
+        #if ((KB_MATRIX_SCAN_BACKOFF_MS) < 1)
+            #error "KB_MATRIX_SCAN_BACKOFF_MS must be at least 1. Fix in kb_config.h"
+        #endif
+        #if ( ((KB_MATRIX_IDLE_WAKE_INTERRUPT) != 0) && ((KB_MATRIX_IDLE_WAKE_INTERRUPT) != 1) )
+            #error "KB_MATRIX_IDLE_WAKE_INTERRUPT must be set to either 0 or 1. Fix in kb_config.h"
+        #endif
         /* TODO: Try to add check for only valid GPIO pins are used. */
 
     #endif /* COMPILECHECKS_H */
@@ -0,0 +1,276 @@
+/**
+ * @file debounce.c
+ * @author Ian Ress
+ * @brief Debounce engine for the bit-packed key matrix. The algorithm is chosen at compile-time
+ * with KB_DEBOUNCE_ALGORITHM in kb_config.h.
+ * 
+ * KB_DEBOUNCE_DEFERRED: A key's debounced state only changes once its raw reading has differed from
+ * the debounced state for KB_DEBOUNCE_TIME_MS. Uses the systick and a small pool of timers.
+ * 
+ * KB_DEBOUNCE_ASYMMETRIC: Same as KB_DEBOUNCE_DEFERRED except presses wait KB_DEBOUNCE_PRESS_TIME_MS and
+ * releases wait KB_DEBOUNCE_RELEASE_TIME_MS.
+ * 
+ * KB_DEBOUNCE_EAGER: A key's debounced state changes on the first scan its raw reading differs. The key
+ * then holds a timer from the same pool and further changes are ignored until KB_DEBOUNCE_TIME_MS passes.
+ * 
+ * KB_DEBOUNCE_VERTICAL_COUNTER: Every key has a 2-bit counter that counts consecutive scans where its
+ * raw reading differs from its debounced state. The counter bits are spread across two bitmaps so a
+ * whole word of keys is counted with a handful of bitwise operations. A key's debounced state changes
+ * after 4 consecutive differing scans. The cost is constant per scan with no branches per key and no
+ * systick reads, so the debounce window is 4 scan periods rather than KB_DEBOUNCE_TIME_MS.
+ * 
+ * The algorithm checks below are on constants and fold away. Defining DEBOUNCE_RUNTIME_CONFIG (E.g. in the host 
+ * build) compiles every algorithm instead so Debounce_Configure() can switch between them at run-time.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include <stdbool.h>
+#include "debounce.h"
+#include "systick.h"
+
+/**
+ * @brief Debounce windows in milliseconds for a key changing to pressed and to released, as configured in 
+ * kb_config.h.
+ * 
+ */
+#if (KB_DEBOUNCE_ALGORITHM == KB_DEBOUNCE_ASYMMETRIC)
+	#define DEBOUNCE_CONFIG_PRESS_TIME_MS		KB_DEBOUNCE_PRESS_TIME_MS
+	#define DEBOUNCE_CONFIG_RELEASE_TIME_MS		KB_DEBOUNCE_RELEASE_TIME_MS
+#else
+	#define DEBOUNCE_CONFIG_PRESS_TIME_MS		KB_DEBOUNCE_TIME_MS
+	#define DEBOUNCE_CONFIG_RELEASE_TIME_MS		KB_DEBOUNCE_TIME_MS
+#endif
+
+/**
+ * @brief The algorithm and windows in use, and which algorithms' state is compiled in.
+ * 
+ */
+#if defined(DEBOUNCE_RUNTIME_CONFIG)
+	static uint8_t debounce_algorithm = KB_DEBOUNCE_ALGORITHM;
+	static systick_wordsize_t debounce_press_time_ms = (systick_wordsize_t)DEBOUNCE_CONFIG_PRESS_TIME_MS;
+	static systick_wordsize_t debounce_release_time_ms = (systick_wordsize_t)DEBOUNCE_CONFIG_RELEASE_TIME_MS;
+
+	#define DEBOUNCE_ALGORITHM					debounce_algorithm
+	#define DEBOUNCE_PRESS_TIME_MS				debounce_press_time_ms
+	#define DEBOUNCE_RELEASE_TIME_MS			debounce_release_time_ms
+	#define DEBOUNCE_USES_SLOTS					1
+	#define DEBOUNCE_USES_VERTICAL_COUNTER		1
+#else
+	#define DEBOUNCE_ALGORITHM					KB_DEBOUNCE_ALGORITHM
+	#define DEBOUNCE_PRESS_TIME_MS				DEBOUNCE_CONFIG_PRESS_TIME_MS
+	#define DEBOUNCE_RELEASE_TIME_MS			DEBOUNCE_CONFIG_RELEASE_TIME_MS
+	#define DEBOUNCE_USES_SLOTS					((KB_DEBOUNCE_ALGORITHM) != KB_DEBOUNCE_VERTICAL_COUNTER)
+	#define DEBOUNCE_USES_VERTICAL_COUNTER		((KB_DEBOUNCE_ALGORITHM) == KB_DEBOUNCE_VERTICAL_COUNTER)
+#endif
+
+#if (DEBOUNCE_USES_SLOTS)
+
+/**
+ * @brief Marks a debounce slot as unused.
+ * 
+ */
+#define DEBOUNCE_SLOT_FREE					0xFFU
+
+/**
+ * @brief Debounce timer for a single key whose raw reading differs from its debounced state, or for a key
+ * that is locked out in KB_DEBOUNCE_EAGER. Slots are only held while a key is bouncing, so only 
+ * KB_DEBOUNCE_MAX_BOUNCING_KEYS timers are kept instead of one timer for every key on the Keyboard.
+ * 
+ */
+typedef struct
+{
+	uint8_t strobe;					/* Index of the key's strobed output. DEBOUNCE_SLOT_FREE if the slot is unused. */
+	uint8_t sense;					/* Index of the key's sampled input. */
+	systick_wordsize_t start;		/* When the key's raw reading first differed from its debounced state. */
+	uint8_t pressing;				/* Non-zero if the key is changing to pressed. Selects the debounce window. */
+} Debounce_Slot_t;
+
+static matrix_word_t tracked[MATRIX_NUMBER_OF_STROBES];		/* Keys that currently hold a debounce slot. */
+static Debounce_Slot_t slots[KB_DEBOUNCE_MAX_BOUNCING_KEYS];
+static uint8_t slots_used = 0;
+static systick_wordsize_t g_ms_copy = 0;
+
+#endif
+
+#if (DEBOUNCE_USES_VERTICAL_COUNTER)
+
+/* Vertical counters. Bit s of cnt0[o] and cnt1[o] together form the 2-bit counter of key (o, s). Stored 
+   inverted so reset = all 1s. */
+static matrix_word_t cnt0[MATRIX_NUMBER_OF_STROBES];
+static matrix_word_t cnt1[MATRIX_NUMBER_OF_STROBES];
+
+#endif
+
+
+#if (DEBOUNCE_USES_SLOTS)
+/**
+ * @brief Debounces the entire matrix with the slot-based algorithms. See Debounce_Matrix().
+ * 
+ */
+static void debounce_slots(const matrix_word_t * const raw, matrix_word_t * const debounced);
+static void debounce_slots(const matrix_word_t * const raw, matrix_word_t * const debounced)
+{
+	g_ms_copy = Systick_Get_Ms();
+
+	/* Update keys that are already being timed. */
+	for (uint8_t i = 0; (i < KB_DEBOUNCE_MAX_BOUNCING_KEYS) && slots_used; i++) {
+		Debounce_Slot_t * const slot = &slots[i];
+
+		if (slot->strobe == DEBOUNCE_SLOT_FREE) {
+			continue;
+		}
+
+		const uint8_t o = slot->strobe;
+		const matrix_word_t mask = ((matrix_word_t)1U << slot->sense);
+
+		/* Handle lower-bound overflow cases. E.g. (systick_wordsize_t)(5-65535) = 6 which is desired since
+		g_ms wraps around to 0 on overflow, so this still gives us the amount of time passed. */
+		const systick_wordsize_t elapsed = (systick_wordsize_t)(g_ms_copy - slot->start);
+		const systick_wordsize_t window = slot->pressing ? (systick_wordsize_t)DEBOUNCE_PRESS_TIME_MS : 
+															(systick_wordsize_t)DEBOUNCE_RELEASE_TIME_MS;
+
+		if (DEBOUNCE_ALGORITHM == KB_DEBOUNCE_EAGER) {
+			if (elapsed < window) {
+				continue; /* Still locked out. */
+			}
+			/* Lockout over. If the key changed during the lockout it is picked up below on this same scan. */
+		}
+		else if ((raw[o] ^ debounced[o]) & mask) {
+			if (elapsed < window) {
+				continue; /* Still bouncing. */
+			}
+			debounced[o] ^= mask;
+		}
+		/* Either the key was debounced, it settled back to its debounced state or its lockout ended. */
+
+		/* Release the slot. */
+		tracked[o] &= (matrix_word_t)~mask;
+		slot->strobe = DEBOUNCE_SLOT_FREE;
+		slots_used--;
+	}
+
+	/* Start timing keys that just changed. */
+	for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++) {
+		matrix_word_t untracked = (raw[o] ^ debounced[o]) & (matrix_word_t)~tracked[o];
+
+		for (uint8_t i = 0; untracked && (i < KB_DEBOUNCE_MAX_BOUNCING_KEYS); i++) {
+			if (slots[i].strobe != DEBOUNCE_SLOT_FREE) {
+				continue;
+			}
+
+			uint8_t sense = 0;
+			while (!(untracked & ((matrix_word_t)1U << sense))) {
+				sense++;
+			}
+
+			slots[i].strobe = o;
+			slots[i].sense = sense;
+			slots[i].start = g_ms_copy;
+			slots[i].pressing = (raw[o] >> sense) & 1U;
+			slots_used++;
+
+			tracked[o] |= ((matrix_word_t)1U << sense);
+			if (DEBOUNCE_ALGORITHM == KB_DEBOUNCE_EAGER) {
+				debounced[o] ^= ((matrix_word_t)1U << sense); /* Report on the first edge then lock the key out. */
+			}
+			untracked &= (matrix_word_t)(untracked - 1U); /* Clear lowest set bit. */
+		}
+		/* If every slot is taken the remaining keys are picked up on a later scan once a slot frees. In 
+		KB_DEBOUNCE_EAGER this delays their report rather than reporting them without a lockout. */
+	}
+}
+#endif
+
+
+#if (DEBOUNCE_USES_VERTICAL_COUNTER)
+/**
+ * @brief Debounces the entire matrix with the vertical counters. See Debounce_Matrix().
+ * 
+ */
+static void debounce_vertical_counter(const matrix_word_t * const raw, matrix_word_t * const debounced);
+static void debounce_vertical_counter(const matrix_word_t * const raw, matrix_word_t * const debounced)
+{
+	for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++) {
+		matrix_word_t delta = raw[o] ^ debounced[o];		/* Keys that differ from their debounced state. */
+
+		cnt0[o] = (matrix_word_t)~(cnt0[o] & delta);		/* Count down bit 0, or reset keys that agree. */
+		cnt1[o] = cnt0[o] ^ (cnt1[o] & delta);				/* Count down bit 1, or reset keys that agree. */
+		delta &= cnt0[o] & cnt1[o];							/* Keys whose counter rolled over after 4 differing scans. */
+
+		debounced[o] ^= delta;
+	}
+}
+#endif
+
+
+/**
+ * @brief Resets the debounce engine. Every key starts debounced as released.
+ * 
+ */
+void Debounce_Init(void)
+{
+	#if (DEBOUNCE_USES_SLOTS)
+		for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++) {
+			tracked[o] = 0;
+		}
+
+		for (uint8_t i = 0; i < KB_DEBOUNCE_MAX_BOUNCING_KEYS; i++) {
+			slots[i].strobe = DEBOUNCE_SLOT_FREE;
+		}
+		slots_used = 0;
+	#endif
+
+	#if (DEBOUNCE_USES_VERTICAL_COUNTER)
+		for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++) {
+			cnt0[o] = (matrix_word_t)~(matrix_word_t)0;
+			cnt1[o] = (matrix_word_t)~(matrix_word_t)0;
+		}
+	#endif
+}
+
+
+/**
+ * @brief Debounces the entire matrix. Must be called once per scan after every strobed output has been sampled.
+ * 
+ * @param raw Readings from the most recent scan. One word per strobed output - see matrix.c.
+ * @param debounced Debounced key states. Updated in place.
+ * 
+ */
+void Debounce_Matrix(const matrix_word_t * const raw, matrix_word_t * const debounced)
+{
+	#if (DEBOUNCE_USES_VERTICAL_COUNTER)
+		if (DEBOUNCE_ALGORITHM == KB_DEBOUNCE_VERTICAL_COUNTER) {
+			debounce_vertical_counter(raw, debounced);
+			return;
+		}
+	#endif
+
+	#if (DEBOUNCE_USES_SLOTS)
+		debounce_slots(raw, debounced);
+	#endif
+}
+
+
+#if defined(DEBOUNCE_RUNTIME_CONFIG)
+/**
+ * @brief Switches the debounce algorithm and windows at run-time and resets the debounce engine. Only available 
+ * when DEBOUNCE_RUNTIME_CONFIG is defined. Otherwise the settings in kb_config.h are used.
+ * 
+ * @param algorithm KB_DEBOUNCE_DEFERRED, KB_DEBOUNCE_EAGER, KB_DEBOUNCE_ASYMMETRIC or 
+ * KB_DEBOUNCE_VERTICAL_COUNTER.
+ * @param press_time_ms Window before a press registers. The lockout after a press for KB_DEBOUNCE_EAGER.
+ * @param release_time_ms Window before a release registers. The lockout after a release for KB_DEBOUNCE_EAGER.
+ * 
+ */
+void Debounce_Configure(uint8_t algorithm, systick_wordsize_t press_time_ms, systick_wordsize_t release_time_ms)
+{
+	debounce_algorithm = algorithm;
+	debounce_press_time_ms = press_time_ms;
+	debounce_release_time_ms = release_time_ms;
+	Debounce_Init();
+}
+#endif
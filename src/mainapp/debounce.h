@@ -0,0 +1,27 @@
+/**
+ * @file debounce.h
+ * @author Ian Ress
+ * @brief Debounce engine for the bit-packed key matrix. The algorithm is chosen at compile-time
+ * with KB_DEBOUNCE_ALGORITHM in kb_config.h, unless DEBOUNCE_RUNTIME_CONFIG is defined. See debounce.c.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+#include "kb_config.h"
+#include "matrix.h"
+#include "systick.h"
+
+void Debounce_Init(void);
+void Debounce_Matrix(const matrix_word_t * const raw, matrix_word_t * const debounced);
+
+#if defined(DEBOUNCE_RUNTIME_CONFIG)
+void Debounce_Configure(uint8_t algorithm, systick_wordsize_t press_time_ms, systick_wordsize_t release_time_ms);
+#endif
+
+#endif /* DEBOUNCE_H */
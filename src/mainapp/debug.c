@@ -72,10 +72,7 @@ void systick_blink(systick_wordsize_t freq)
     while (1)
     {
 
-        ATOMIC_BLOCK(ATOMIC_FORCEON)
-        {
-            g_ms_copy = g_ms;
-        }
+        g_ms_copy = Systick_Get_Ms();
 
         if ( ((systick_wordsize_t)(g_ms_copy - wait)) >= freq )
         {
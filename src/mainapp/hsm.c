@@ -104,6 +104,118 @@ static bool Hsm_Init_Dispatch(Hsm * const me, const HsmInitStateHandler inithndl
 }
 
 
+/**
+ * @brief Never call directly. Looks up the precomputed path of a transition in the Hsm's
+ * table of transition paths. See Hsm_Set_Tran_Paths().
+ * 
+ * @param me Pointer to Hsm object.
+ * @param source The state whose handler made the transition.
+ * @param target The state transitioned into.
+ * 
+ * @return Pointer to the transition path. NULL if the Hsm has no table or the transition
+ * is not in it.
+ * 
+ */
+static const HsmTranPath * Hsm_Find_Tran_Path(const Hsm * const me, const HsmState * const source, const HsmState * const target);
+static const HsmTranPath * Hsm_Find_Tran_Path(const Hsm * const me, const HsmState * const source, const HsmState * const target)
+{
+    for (const HsmTranPath * path = me->tranPaths; (path) && (path->source); path++)
+    {
+        if ( (path->source == source) && (path->target == target) )
+        {
+            return path;
+        }
+    }
+    return (HsmTranPath *)0;
+}
+
+
+/**
+ * @brief Never call directly. Determines the Exit and Entry paths of a transition at 
+ * run-time and executes them. Used when a transition has no precomputed path.
+ * 
+ * Source State = state whose handler made the transition. Similar to the node of a tree.
+ * Target State = state we just transitioned into. Similar to the node of a tree.
+ * Top State = similar to the root of a tree
+ * LCA = Least Common Ancestor. Lowest level state shared between two states.
+ * 
+ * The path from each node to the root is known since each node can only have one parent 
+ * (superstate). The LCA is the first state on the Target's path that is also on the Source's 
+ * path. For a State to State Transition, the LCA is moved one level up if it is the Source or 
+ * Target State itself, so that state is exited and entered again. For Nested State Transitions 
+ * it stays. See HSM_INTERNAL_TRAN(target_) macro.
+ * 
+ * The order of Exit Events will be from the Source State up to the LCA.
+ * The order of Entry Events will be from the LCA to the Target State.
+ * 
+ * @param me Pointer to Hsm object.
+ * @param source The state whose handler made the transition.
+ * @param target The state transitioned into.
+ * @param status HSM_TRAN_STATUS or HSM_INTERNAL_TRAN_STATUS.
+ * 
+ */
+static void Hsm_Run_Tran(Hsm * const me, HsmState * const source, HsmState * const target, const HsmStatus status);
+static void Hsm_Run_Tran(Hsm * const me, HsmState * const source, HsmState * const target, const HsmStatus status)
+{
+    int levels = 0;
+    HsmState * LCA = NULL_STATE;
+    HsmState * s;
+    HsmState * t;
+
+    HsmState * entryPath[MAX_LEVELS+2] = {NULL_STATE};
+    HsmState ** entryTrace = &entryPath[1];
+
+    /**
+     * Find LCA
+     */
+    for ( t = target; (t != NULL_STATE) && (LCA == NULL_STATE); t = t->superstate )
+    {
+        for ( s = source; s != NULL_STATE; s = s->superstate )
+        {
+            if (s == t)
+            {
+                LCA = t;
+                break;
+            }
+        }
+    }
+
+    if ( (status == HSM_TRAN_STATUS) && ((LCA == source) || (LCA == target)) )
+    {
+        LCA = LCA->superstate;
+    }
+
+    /**
+     * Trace from the Target State up to the LCA
+     */
+    for ( t = target; t != LCA; t = t->superstate )
+    {
+        if (levels++ > MAX_LEVELS)
+        {
+            // TODO: throw run-time error
+            return;
+        }
+        else
+        {
+            *(entryTrace++) = t; /* {0, Target State, Superstate,...Substate of LCA} */
+        }
+    }
+
+    /**
+     * Execute Exit and Entry Events
+     */
+    for ( s = source; s != LCA; s = s->superstate )
+    {
+        (void)(*s->hndlr)(me, &exitEvent);
+    }
+
+    while ( *(--entryTrace) )   /* Recall first element of entryPath is (HsmState *)0 */
+    {
+        (void)(*(*entryTrace)->hndlr)(me, &entryEvent);
+    }
+}
+
+
 /**
  * @brief Initializes a State within the Hsm. 
  * 
@@ -119,7 +231,7 @@ static bool Hsm_Init_Dispatch(Hsm * const me, const HsmInitStateHandler inithndl
  */
 void HsmState_Ctor(HsmState * const me, const HsmState * const superstate, const HsmStateHandler hndlr)
 {
-    me->superstate = superstate;
+    me->superstate = (HsmState *)superstate;
     me->hndlr = hndlr;
 }
 
@@ -140,6 +252,30 @@ void Hsm_Ctor(Hsm * const me, const HsmStateHandler tophndlr)
 {
     HsmState_Ctor(&me->top, (HsmState *)0, tophndlr);
     me->state = (HsmState *)0;
+    me->tranPaths = (HsmTranPath *)0;
+}
+
+
+/**
+ * @brief Gives the Hsm a table of precomputed transition paths. When a transition in the 
+ * table occurs, the Dispatcher walks its Exit and Entry paths directly instead of tracing 
+ * the State hierarchy and searching for the LCA. This bounds the time a transition takes.
+ * Transitions not in the table are still determined at run-time.
+ * 
+ * @warning The paths are not checked against the State hierarchy. They must match the
+ * superstate pointers of the Hsm's states or the wrong Exit and Entry Events will execute.
+ * 
+ * @param me Pointer to Hsm object.
+ * @param paths Array of transition paths, ideally declared const. The last element must 
+ * have a NULL source. NULL to determine every transition path at run-time.
+ * 
+ */
+void Hsm_Set_Tran_Paths(Hsm * const me, const HsmTranPath * const paths)
+{
+    if (me)
+    {
+        me->tranPaths = paths;
+    }
 }
 
 
@@ -170,7 +306,7 @@ void Hsm_Ctor(Hsm * const me, const HsmStateHandler tophndlr)
  * before calling this routine. False otherwise.
  * 
  */
-bool Hsm_Begin(Hsm * const me, const HsmStateHandler inithndlr)
+bool Hsm_Begin(Hsm * const me, const HsmInitStateHandler inithndlr)
 {
     bool success = false;
 
@@ -194,8 +330,10 @@ bool Hsm_Begin(Hsm * const me, const HsmStateHandler inithndlr)
  * made in the Entry or Exit Events.
  * 
  * @brief Runs the Hsm. If a state transition takes place, the dispatcher
- * determines the entry and exit paths and executes the Entry and Exit
- * Events of the appropriate states.
+ * executes the Exit Events from the current state up to the state that
+ * made the transition. The rest of the Exit and Entry Events come from
+ * the Hsm's precomputed transition paths if the transition is in it.
+ * Otherwise they are determined at run-time. See Hsm_Set_Tran_Paths().
  * 
  * @warning Do not execute this in multiple threads. If you need multiple
  * threads or ISRs to dispatch events to the Hsm, add the event to a queue.
@@ -214,161 +352,48 @@ void Hsm_Dispatch(Hsm * const me, const Event * const e)
     }
 
     HsmState * const StartState = me->state;
-    HsmState * HandledState = me->state; /* Stores the state that handled the dispatched event. */
+    HsmState * HandledState; /* Stores the state that handled the dispatched event. */
+    HsmStatus status;
 
     /* Execute dispatched event in current state's Event Handler. Exits when event is handled. */
-    HsmStatus status = (*me->state->hndlr)(me, e);
-    while (status == HSM_SUPER_STATUS)
+    do
     {
         HandledState = me->state;
         status = (*me->state->hndlr)(me, e);
-    }
+    } while ( (status == HSM_SUPER_STATUS) && (me->state) );
 
     /* Did the dispatched event cause a State Transition? */
     if ( (status == HSM_TRAN_STATUS || status == HSM_INTERNAL_TRAN_STATUS) )
     {
-        /* Declared here to try to reduce Stack allocation since this is only needed if a State Transition occurs. */
-        int levels = 0;
-        HsmState * LCA;
-        HsmState * s;
-        
-        HsmState * entryPath[MAX_LEVELS+1] = {NULL_STATE};
-        HsmState ** entryTrace = &entryPath[0];
-
-        HsmState * exitPath[MAX_LEVELS+1] = {NULL_STATE};
-        HsmState ** exitTrace = &exitPath[0];
+        HsmState * const TargetState = me->state;
+        const HsmTranPath * const path = Hsm_Find_Tran_Path(me, HandledState, TargetState);
 
-        /**
-         * Source State = state we just transitioned out of. Similar to the node of a tree.
-         * Target State = state we just transitioned into. Similar to the node of a tree.
-         * Top State = similar to the root of a tree
-         * LCA = Least Common Ancestor. Lowest level state shared between two states.
-         * Leaf State = state that has no substates. (state with no children).
-         * 
-         * We must figure out the correct order of Entry and Exit events to run for each state
-         * if a transition occured.
-         * 
-         * We do this by finding the LCA between the Source and Target State, which is 
-         * similar to finding the LCA of a tree. However the path from the root (Top State)
-         * to each node (Target/Source States) is not defined at compile-time to save memory. 
-         * This is calculated here at run-time for only the nodes of interest (Source and Target
-         * States). 
-         * 
-         * Only the path from node to root is defined at compile-time since each 
-         * node can only have one parent (superstate).
-         * Therefore we start with the Source State and trace up the State Hierarchy 
-         * until we reach the Top State. This path is recorded in exitTrace. The same 
-         * process is repeated for the Target State, with the path being recorded in entryTrace. 
-         * 
-         * With the path from root to node now known, we follow the standard LCA algorithm if
-         * a State to State Transition occured. We traverse back down exitPath and entryPath. 
-         * (From root to node). After traversing down each level, we check if the current 
-         * state in entryPath and exitPath are the same. If they are different we know 
-         * that the LCA is the state one level above.
-         * 
-         * For Nested State Transitions, the LCA will be the highest level State from
-         * the following list: the State that handled the dispatched event, the Source State, 
-         * or the Target State. 
-         * 
-         * The order of Exit Events will be from the Source State up to the LCA.
-         * The order of Entry Events will be from the LCA to the Target State.
-         * 
-         */
-
-        /**
-         * Trace up to Top State
-         */
-        for ( s = StartState; s != NULL_STATE; s = s->superstate )
+        /* The event may have been handled in a superstate. Exit up to it first. */
+        for ( HsmState * s = StartState; s != HandledState; s = s->superstate )
         {
-            if (levels++ > MAX_LEVELS)
-            {
-                // TODO: throw run-time error
-                return;
-            }
-            else
-            {
-                *(exitTrace++) = s; /* {0, StartState, ...TopState} */ 
-            }
+            (void)(*s->hndlr)(me, &exitEvent);
         }
 
-        levels = 0;
-        for ( s = me->state; s != NULL_STATE; s = s->superstate )
+        if (path)
         {
-            if (levels++ > MAX_LEVELS)
-            {
-                // TODO: throw run-time error
-                return;
-            }
-            else
+            for ( const HsmState * const * s = path->exitPath; *s; s++ )
             {
-                *(entryTrace++) = s; /* {0, CurrentState, ...TopState} */ 
+                (void)(*(*s)->hndlr)(me, &exitEvent);
             }
-        }
-
-
-        /**
-         * Find LCA
-         */
-        while ( (*exitTrace == *entryTrace) && (*exitTrace != &exitPath[1]) && (*entryTrace != &entryPath[1]) && (*exitTrace != HandledState) && (*entryTrace != HandledState) )
-        {
-            exitTrace--;
-            entryTrace--;
-        }
 
-        LCA = (*exitTrace)
-
-        if ( (*exitTrace == *entryTrace) && (status == HSM_INTERNAL_TRAN_STATUS) ) /* Nested, Internal State Transition. See INTERNAL_TRAN(target_) macro */
-        {
-            LCA = (*exitTrace); /* Same as (*entryTrace) */
-        }
-        else /* State to State Transition. */
-        {
-            LCA = (*exitTrace)->superstate; /* Same as (*entryTrace)->superstate. */
-        }
-
-
-        /**
-         * Execute Exit and Entry Events
-         */
-        if (LCA)
-        {
-            for ( s = StartState; s != LCA; s = s->superstate )
-            {
-                (void)(*s->hndlr)(me, &exitEvent);
-            }
-
-            for ( s = *entryTrace; s; s = *(entryTrace--) )  /* Recall first element of entryTrace is (HsmState *)0 */
+            for ( const HsmState * const * s = path->entryPath; *s; s++ )
             {
-                (void)(*s->hndlr)(me, &entryEvent);
+                (void)(*(*s)->hndlr)(me, &entryEvent);
             }
         }
         else
         {
-            // TODO: throw run-time error
-        }
-
-
-
-
-
-        /**
-         * At this point we know our Entry and Exit paths. Execute Exit and Entry Events
-         */
-        for ( entryTrace = &entryPath[0]; *entryTrace != LCA; entryTrace++ ){} /* Find Entry startpoint */
-        if ( *entryTrace != &entryPath[0] )
-        {
-            entryTrace--;
-        }
-
-        for ( exitTrace = &exitPath[0]; *exitTrace != LCA; exitTrace++ ) /* Exit Events are executed from the Source State up to the LCA. */
-        {
-            (void)(*(*exitTrace)->hndlr)(me, &exitEvent);
-        }
-
-        for ( ; entryTrace != &entryPath[0]; entryTrace-- ) /* Entry Events are executed from the LCA to the Target State. */
-        {
-            (void)(*(*entryTrace)->hndlr)(me, &entryEvent);
+            Hsm_Run_Tran(me, HandledState, TargetState, status);
         }
-        (void)(*me->state->hndlr)(me, &entryEvent);
+        me->state = TargetState;
+    }
+    else
+    {
+        me->state = StartState; /* Undo the HSM_SUPER(super_) traversal. */
     }
 }
@@ -10,11 +10,13 @@
 #ifndef HSM_H
 #define HSM_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "event.h"
 
 /* Hsm Base Class */
-typedef struct Hsm Hsm;     /* Must forward declare for StateHandler typedef. */
+typedef struct Hsm Hsm;             /* Must forward declare for StateHandler typedef. */
+typedef struct HsmState HsmState;   /* Must forward declare for superstate member. */
 
 typedef enum
 {
@@ -33,7 +35,7 @@ typedef enum
 typedef HsmStatus (*HsmStateHandler)(Hsm * const me, const Event * const e);
 typedef HsmStatus (*HsmInitStateHandler)(Hsm * const me);
 
-typedef struct 
+struct HsmState
 {
     HsmState * superstate;      /*  This is a pointer to the State above the current state. For example
                                     if State A11 is nested inside State A1, the State struct of A11 would define
@@ -41,12 +43,33 @@ typedef struct
 
     HsmStateHandler hndlr;      /*  Current state's handler function. This is the function that will execute
                                     when events are dispatched to the Hsm. */
-} HsmState;
+};
+
+/**
+ * @brief The Exit and Entry Event sequence of one transition, determined at compile-time. 
+ * The source is the state whose handler made the transition. This can be a superstate of the 
+ * current state, in which case the Dispatcher first exits up to the source by following the 
+ * superstate pointers. The Dispatcher then runs the Exit Events in exitPath followed by the 
+ * Entry Events in entryPath. No paths or LCA have to be calculated at run-time. The paths 
+ * must follow HSM_TRAN(target_) or HSM_INTERNAL_TRAN(target_), whichever the source uses.
+ * 
+ * For example, a transition from State A1 to State B1 where both have the Top State as their
+ * superstate would have an exitPath of {&A1, 0} and an entryPath of {&B1, 0}.
+ * 
+ */
+typedef struct
+{
+    const HsmState * source;            /*  State that made the transition. NULL marks the end of a table of paths. */
+    const HsmState * target;            /*  State passed to HSM_TRAN(target_) or HSM_INTERNAL_TRAN(target_). */
+    const HsmState * const * exitPath;  /*  States to exit in order, from the source up to the LCA. NULL terminated. */
+    const HsmState * const * entryPath; /*  States to enter in order, from the LCA down to the target. NULL terminated. */
+} HsmTranPath;
 
 struct Hsm
 {
     HsmState top;              /*  Top-most State. It's superstate will be (HsmState *)0 */
     HsmState * state;          /*  The Current State the Hsm is in. */
+    const HsmTranPath * tranPaths; /*  Table of precomputed transition paths. NULL to calculate every path at run-time. */
     /* Private members can be added here in subclass that inherits Hsm Base Class. */
 };
 
@@ -95,7 +118,8 @@ struct Hsm
 
 void HsmState_Ctor(HsmState * const me, const HsmState * const superstate, const HsmStateHandler hndlr);
 void Hsm_Ctor(Hsm * const me, const HsmStateHandler tophndlr);
-bool Hsm_Begin(Hsm * const me, const HsmStateHandler inithndlr);
+void Hsm_Set_Tran_Paths(Hsm * const me, const HsmTranPath * const paths);
+bool Hsm_Begin(Hsm * const me, const HsmInitStateHandler inithndlr);
 void Hsm_Dispatch(Hsm * const me, const Event * const e);
 
 #endif /* HSM_H */
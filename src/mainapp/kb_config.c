@@ -11,5 +11,5 @@
 
 #include "kb_config.h"
 
-const Pinmap_t g_keyboard_rowpins[KB_NUMBER_OF_ROWS] = ROW_PINS;
-const Pinmap_t g_keyboard_colpins[KB_NUMBER_OF_COLUMNS] = COLUMN_PINS;
+const KB_PINSIZE_T g_keyboard_rowpins[KB_NUMBER_OF_ROWS] = ROW_PINS;
+const KB_PINSIZE_T g_keyboard_colpins[KB_NUMBER_OF_COLUMNS] = COLUMN_PINS;
@@ -0,0 +1,54 @@
+/**
+ * @file key_event.c
+ * @author Ian Ress
+ * @brief Queue of key change events between the matrix scanner and the HID report stage. There is 
+ * exactly one producer (Matrix_Scan()) and one consumer (the HID report callback), so the queue is a 
+ * lock-free circbuf_t and either side can run from an ISR. See circular_buffer.h.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include "circular_buffer.h"
+#include "key_event.h"
+
+CIRCBUF_DEFINE(static, queue, Key_Event_t, KB_KEY_EVENT_QUEUE_SIZE);
+
+
+/**
+ * @brief Empties the queue. Must be called before the producer and consumer start.
+ * 
+ */
+void Key_Event_Init(void)
+{
+	circbuf_init(&queue);
+}
+
+
+/**
+ * @brief Adds a key event to the queue if there's space.
+ * 
+ * @param event The event to add. Copied into the queue.
+ * 
+ * @return True if the event was added. False if the queue is full, in which case nothing is written.
+ * 
+ */
+bool Key_Event_Push(const Key_Event_t * const event)
+{
+	return circbuf_write(&queue, event) != 0;
+}
+
+
+/**
+ * @brief Removes the oldest key event from the queue if one is available.
+ * 
+ * @param event Where the removed event is copied to. Untouched if the queue is empty.
+ * 
+ * @return True if an event was removed. False if the queue is empty.
+ * 
+ */
+bool Key_Event_Pop(Key_Event_t * const event)
+{
+	return circbuf_read(&queue, event) != 0;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file key_event.h
+ * @author Ian Ress
+ * @brief Queue of key change events between the matrix scanner and the HID report stage.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef KEY_EVENT_H
+#define KEY_EVENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "kb_config.h"
+#include "systick.h"
+
+/**
+ * @brief A single key changing state. Pushed by Matrix_Scan() when a key's debounced state changes.
+ * 
+ */
+typedef struct
+{
+	uint8_t row;						/* Index into ROW_PINS. */
+	uint8_t column;						/* Index into COLUMN_PINS. */
+	uint8_t pressed;					/* 1 if the key was pressed, 0 if it was released. */
+	systick_wordsize_t timestamp;		/* g_ms at the scan that registered the change. */
+} Key_Event_t;
+
+void Key_Event_Init(void);
+bool Key_Event_Push(const Key_Event_t * const event);
+bool Key_Event_Pop(Key_Event_t * const event);
+
+#endif /* KEY_EVENT_H */
@@ -0,0 +1,62 @@
+/**
+ * @file keyboard_report.c
+ * @author Ian Ress
+ * @brief Builds the Boot Protocol keyboard report from the key event queue. See keyboard_report.h.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include "keyboard_report.h"
+#include "key_event.h"
+
+static uint8_t held_keys = 0;		/* Number of keys currently held, tracked from the key event queue. */
+
+
+/**
+ * @brief Forgets every held key. Must be called along with Key_Event_Init().
+ * 
+ */
+void Keyboard_Report_Init(void)
+{
+	held_keys = 0;
+}
+
+
+/**
+ * @brief Drains every key change queued by the matrix scan since the last report and fills in @p report 
+ * with the keys now held.
+ * 
+ * @param report The report to fill in. Every field is written.
+ * 
+ */
+void Keyboard_Report_Build(Keyboard_Report_t * const report)
+{
+	Key_Event_t event;
+
+	while (Key_Event_Pop(&event))
+	{
+		if (event.pressed)
+		{
+			held_keys++;
+		}
+		else if (held_keys)
+		{
+			held_keys--;
+		}
+	}
+
+	report->modifiers = 0;
+	report->reserved = 0;
+	for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYCODES; i++)
+	{
+		report->keycodes[i] = KEY_NONE;
+	}
+
+	/* Same test placeholder as the debugpress flag this replaced: any held key reports as 'A'. */
+	if (held_keys)
+	{
+		report->keycodes[0] = KEY_A;
+	}
+}
@@ -0,0 +1,38 @@
+/**
+ * @file keyboard_report.h
+ * @author Ian Ress
+ * @brief Builds the Boot Protocol keyboard report from the key event queue. Kept apart from the USB stack so 
+ * the same code runs in the firmware's HID report callback and in the host simulation.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef KEYBOARD_REPORT_H
+#define KEYBOARD_REPORT_H
+
+#include <stdint.h>
+#include "keycodes.h"
+
+/**
+ * @brief Number of keycodes in a Boot Protocol keyboard report.
+ * 
+ */
+#define KEYBOARD_REPORT_KEYCODES			6U
+
+/**
+ * @brief Boot Protocol keyboard report. Same layout as the 8 bytes sent on the IN endpoint.
+ * 
+ */
+typedef struct
+{
+	uint8_t modifiers;							/* Bitmap of the KEY_LEFT_CTRL... modifier keys. */
+	uint8_t reserved;
+	uint8_t keycodes[KEYBOARD_REPORT_KEYCODES];	/* Usage IDs of the held keys. KEY_NONE in unused entries. */
+} Keyboard_Report_t;
+
+void Keyboard_Report_Init(void);
+void Keyboard_Report_Build(Keyboard_Report_t * const report);
+
+#endif /* KEYBOARD_REPORT_H */
@@ -31,8 +31,11 @@ int main(void)
 	// USB_Init();
 	// /* Wait for enumeration phase to complete */
 
-	// (void)Create_Task(Matrix_Scan, 20);
-	// (void)Create_Task(USB_HIDTask, 5);
+	// Task_t * const scantask = Create_Task(Matrix_Scan, KB_MATRIX_SCAN_PERIOD_MIN_MS);
+	// Set_Task_Timing(scantask, TASK_FIXED_RATE_SKIP); /* Stay in phase with the USB poll. */
+	// Set_Task_Priority(scantask, TASK_PRIORITY_HIGH);
+	// Matrix_Set_Task(scantask);
+	// Set_Task_Priority(Create_Task(USB_HIDTask, 5), TASK_PRIORITY_HIGH);
 
 	// Systick_Start();
 	// sei();
@@ -40,5 +43,6 @@ int main(void)
 	// while(1)
 	// {
 	// 	Begin_Scheduler();
+	// 	Scheduler_Idle();
 	// }
 }
@@ -12,46 +12,393 @@
 #include <stdbool.h>
 #include <avr/io.h>
 #include <util/atomic.h>
-#include "debug.h"
+#include <util/delay.h>
 #include "bsp_gpio.h"
+#include "debounce.h"
+#include "key_event.h"
+#include "kb_config.h"
 #include "matrix.h"
+#include "scheduler.h"
 #include "systick.h"
+#include "unroll.h"
 
-static uint16_t matrix_state[KB_NUMBER_OF_ROWS][KB_NUMBER_OF_COLUMNS] = {{0}};
+/**
+ * @brief The pins strobed and the pins sampled each scan. See KB_MATRIX_STROBE_ROWS in kb_config.h. These are 
+ * copies of ROW_PINS and COLUMN_PINS local to this file rather than g_keyboard_rowpins[] and g_keyboard_colpins[], 
+ * so the compiler can see their values. Indexing them with a constant (see KB_MATRIX_UNROLLED_SCAN) folds 
+ * BSP_GET_PORT() and BSP_GET_PIN() away and leaves a single SBI/CBI/SBIC instruction per GPIO access.
+ * 
+ */
+#if (KB_MATRIX_STROBE_ROWS == 1)
+	static const KB_PINSIZE_T matrix_strobe_pins[MATRIX_NUMBER_OF_STROBES] = ROW_PINS;
+	static const KB_PINSIZE_T matrix_sense_pins[MATRIX_NUMBER_OF_SENSES] = COLUMN_PINS;
+#else
+	static const KB_PINSIZE_T matrix_strobe_pins[MATRIX_NUMBER_OF_STROBES] = COLUMN_PINS;
+	static const KB_PINSIZE_T matrix_sense_pins[MATRIX_NUMBER_OF_SENSES] = ROW_PINS;
+#endif
 
-static bool debounce_logic(uint8_t row, uint8_t col);
+#define MATRIX_STROBE_PINS						matrix_strobe_pins
+#define MATRIX_SENSE_PINS						matrix_sense_pins
 
-static systick_wordsize_t g_ms_copy = 0;
-uint8_t keypress = 0;
-uint8_t debugpress = 0;
+#if (KB_MATRIX_UNROLLED_SCAN == 1)
+	/**
+	 * @brief One step of the unrolled scanner. Identical to one iteration of the loop in matrix_scan_once() 
+	 * except o is a literal, so every pin below is a constant. The modulo only keeps the index of the last 
+	 * output in range. That branch is removed at compile time.
+	 * 
+	 */
+	#define MATRIX_SCAN_STROBE(o)																		\
+		matrix_sample_senses(&sample);																	\
+		matrix_strobe_idle(MATRIX_STROBE_PINS[o]);														\
+		if (((o) + 1U) < MATRIX_NUMBER_OF_STROBES) {													\
+			matrix_strobe_active(MATRIX_STROBE_PINS[((o) + 1U) % MATRIX_NUMBER_OF_STROBES]);			\
+		}																								\
+		matrix_raw[o] = matrix_decode_senses(&sample);													\
+		if (((o) + 1U) < MATRIX_NUMBER_OF_STROBES) {													\
+			matrix_settle();																			\
+		}
+
+	/**
+	 * @brief Reads input s of the unrolled scanner into sample->pins.
+	 * 
+	 */
+	#define MATRIX_SAMPLE_SENSE(s)																		\
+		if (BSP_GPIO_Read(MATRIX_SENSE_PINS[s])) {														\
+			sample->pins |= ((matrix_word_t)1U << (s));													\
+		}
+#endif
+
+/**
+ * @brief Set if the sampled inputs are read a whole GPIO Port at a time using the Port tables built in 
+ * Matrix_Init(). The unrolled scanner reads every input with its own single instruction instead, which 
+ * costs the same as extracting the input from a Port reading.
+ * 
+ */
+#if ((KB_MATRIX_PORT_WIDE_SAMPLING == 1) && (KB_MATRIX_UNROLLED_SCAN == 0))
+	#define MATRIX_PORT_TABLES					1
+#else
+	#define MATRIX_PORT_TABLES					0
+#endif
 
 /**
- * @brief Reads the pressed key when it is debounced. If it is pressed, the relevant key is
- * stored in a USB transmit buffer.
+ * @brief Bitmap with a bit set for every sampled input.
  * 
- * @param row Matrix row index of the key.
- * @param col Matrix column index of the key. 
+ */
+#define MATRIX_ALL_SENSES_MASK				((matrix_word_t)((matrix_word_t)~(matrix_word_t)0 >> ((sizeof(matrix_word_t) * 8U) - MATRIX_NUMBER_OF_SENSES)))
+
+/**
+ * Bit-packed matrix state. Each word holds one bit per sampled input for a single strobed output. Bit s 
+ * of word o is the key at MATRIX_STROBE_PINS[o] and MATRIX_SENSE_PINS[s]. A set bit means pressed.
+ */
+static matrix_word_t matrix_raw[MATRIX_NUMBER_OF_STROBES];			/* Readings from the most recent scan. */
+static matrix_word_t matrix_debounced[MATRIX_NUMBER_OF_STROBES];		/* Debounced key states. */
+static matrix_word_t matrix_previous[MATRIX_NUMBER_OF_STROBES];		/* Debounced key states from the previous scan. */
+
+/**
+ * @brief Raw readings of every input taken while one output is strobed. Holds whole Port readings if 
+ * MATRIX_PORT_TABLES is set, otherwise one bit per input.
  * 
  */
-static bool debounce_logic(uint8_t row, uint8_t col)
+typedef struct
 {
-	ATOMIC_BLOCK(ATOMIC_FORCEON)
-	{
-		g_ms_copy = g_ms;
+	#if (MATRIX_PORT_TABLES == 1)
+		BSP_GPIO_PORT_T ports[MATRIX_NUMBER_OF_SENSES];
+	#else
+		matrix_word_t pins;
+	#endif
+} Matrix_Sample_t;
+
+static inline void matrix_strobe_active(KB_PINSIZE_T pin);
+static inline void matrix_strobe_idle(KB_PINSIZE_T pin);
+static inline void matrix_sample_senses(Matrix_Sample_t * const sample);
+static inline matrix_word_t matrix_decode_senses(const Matrix_Sample_t * const sample);
+static inline matrix_word_t matrix_read_senses(void);
+static inline void matrix_settle(void);
+static void matrix_scan_once(void);
+
+#if (MATRIX_PORT_TABLES == 1)
+	static uint8_t sense_ports[MATRIX_NUMBER_OF_SENSES];				/* Distinct GPIO Ports the sampled inputs are connected to. */
+	static uint8_t sense_port_count = 0;								/* Number of valid entries in sense_ports[]. */
+	static uint8_t sense_port_index[MATRIX_NUMBER_OF_SENSES];			/* Index into sense_ports[] that each input is read from. */
+	static BSP_GPIO_PORT_T sense_pin_masks[MATRIX_NUMBER_OF_SENSES];	/* Each input's bit within its Port reading. */
+#endif
+
+/**
+ * @brief Limits of the adaptive scan rate, as configured in kb_config.h. Defining MATRIX_RUNTIME_CONFIG (E.g. in 
+ * the host build) keeps them in variables instead so Matrix_Configure_Scan_Rate() can change them at run-time.
+ * 
+ */
+#if defined(MATRIX_RUNTIME_CONFIG)
+	static systick_wordsize_t matrix_scan_period_min_ms = (systick_wordsize_t)KB_MATRIX_SCAN_PERIOD_MIN_MS;
+	static systick_wordsize_t matrix_scan_period_max_ms = (systick_wordsize_t)KB_MATRIX_SCAN_PERIOD_MAX_MS;
+	static systick_wordsize_t matrix_scan_backoff_ms = (systick_wordsize_t)KB_MATRIX_SCAN_BACKOFF_MS;
+
+	#define MATRIX_SCAN_PERIOD_MIN_MS			matrix_scan_period_min_ms
+	#define MATRIX_SCAN_PERIOD_MAX_MS			matrix_scan_period_max_ms
+	#define MATRIX_SCAN_BACKOFF_MS				matrix_scan_backoff_ms
+#else
+	#define MATRIX_SCAN_PERIOD_MIN_MS			((systick_wordsize_t)KB_MATRIX_SCAN_PERIOD_MIN_MS)
+	#define MATRIX_SCAN_PERIOD_MAX_MS			((systick_wordsize_t)KB_MATRIX_SCAN_PERIOD_MAX_MS)
+	#define MATRIX_SCAN_BACKOFF_MS				((systick_wordsize_t)KB_MATRIX_SCAN_BACKOFF_MS)
+#endif
+
+static Task_t * matrix_task = NULL;									/* Scheduler task running Matrix_Scan(). See Matrix_Set_Task(). */
+static systick_wordsize_t matrix_scan_period = KB_MATRIX_SCAN_PERIOD_MIN_MS;	/* Current period of matrix_task in ms. */
+static systick_wordsize_t matrix_last_activity = 0;					/* Timestamp of the last scan that saw activity, or of the last back-off step. */
+
+static inline bool matrix_is_quiet(void);
+static void matrix_queue_events(systick_wordsize_t timestamp);
+static void matrix_update_scan_rate(systick_wordsize_t now);
+
+#if (KB_MATRIX_IDLE_WAKE_INTERRUPT == 1)
+	static volatile bool matrix_idle = false;							/* True while scanning is stopped and the wake interrupts are armed. */
+	static bool matrix_wake_capable = false;							/* True if every sampled input can interrupt on a pin change. */
+	static Task_Timing_t matrix_task_timing = TASK_FIXED_DELAY;			/* Timing of matrix_task to restore when leaving idle. */
+
+	static void matrix_enter_idle(void);
+	static void matrix_leave_idle(void);
+	static void matrix_wake(void);
+
+	BSP_GPIO_WAKE_ISR(matrix_wake);
+#endif
+
+/**
+ * @brief Drives an output to the level that registers a keypress on the sampled inputs.
+ * 
+ * @param pin The Row/Column being strobed.
+ * 
+ */
+static inline void matrix_strobe_active(KB_PINSIZE_T pin)
+{
+	#if (KB_MATRIX_STROBE_LEVEL == KB_PIN_LOW)
+		BSP_GPIO_Set_Output_Push_Pull_Low(pin);
+	#else
+		BSP_GPIO_Set_Output_Push_Pull_High(pin);
+	#endif
+}
+
+/**
+ * @brief Returns an output to its idle level so it no longer registers keypresses on the sampled inputs.
+ * 
+ * @param pin The Row/Column being released.
+ * 
+ */
+static inline void matrix_strobe_idle(KB_PINSIZE_T pin)
+{
+	#if (KB_MATRIX_STROBE_LEVEL == KB_PIN_LOW)
+		BSP_GPIO_Set_Output_Push_Pull_High(pin);
+	#else
+		BSP_GPIO_Set_Output_Push_Pull_Low(pin);
+	#endif
+}
+
+/**
+ * @brief Captures the raw readings of every input for the output that is currently strobed. If 
+ * KB_MATRIX_PORT_WIDE_SAMPLING is set, each GPIO Port the inputs are connected to is read once and stored 
+ * as is. Otherwise each input pin is read individually. Kept as short as possible so the strobed output 
+ * can be released right after.
+ * 
+ * @param sample Where the raw readings are stored. Decode with matrix_decode_senses().
+ * 
+ */
+static inline void matrix_sample_senses(Matrix_Sample_t * const sample)
+{
+	#if (MATRIX_PORT_TABLES == 1)
+		for (uint8_t p = 0; p < sense_port_count; p++) {
+			sample->ports[p] = BSP_GPIO_Read_Port(sense_ports[p]);
+		}
+	#elif (KB_MATRIX_UNROLLED_SCAN == 1)
+		sample->pins = 0;
+		UNROLL(MATRIX_NUMBER_OF_SENSES, MATRIX_SAMPLE_SENSE)
+	#else
+		sample->pins = 0;
+
+		for (uint8_t s = 0; s < MATRIX_NUMBER_OF_SENSES; s++) {
+			if (BSP_GPIO_Read(MATRIX_SENSE_PINS[s])) {
+				sample->pins |= ((matrix_word_t)1U << s);
+			}
+		}
+	#endif
+}
+
+/**
+ * @brief Converts raw readings captured by matrix_sample_senses() into keypresses. Does not touch any GPIO, 
+ * so it can run while the next output is settling.
+ * 
+ * @param sample Raw readings captured by matrix_sample_senses().
+ * 
+ * @return Bitmap of the inputs that registered a keypress. Bit s corresponds to MATRIX_SENSE_PINS[s].
+ * 
+ */
+static inline matrix_word_t matrix_decode_senses(const Matrix_Sample_t * const sample)
+{
+	matrix_word_t senses = 0;
+
+	#if (MATRIX_PORT_TABLES == 1)
+		for (uint8_t s = 0; s < MATRIX_NUMBER_OF_SENSES; s++) {
+			if (sample->ports[sense_port_index[s]] & sense_pin_masks[s]) {
+				senses |= ((matrix_word_t)1U << s);
+			}
+		}
+	#else
+		senses = sample->pins;
+	#endif
+
+	#if (KB_MATRIX_STROBE_LEVEL == KB_PIN_LOW)
+		senses = (matrix_word_t)(~senses) & MATRIX_ALL_SENSES_MASK;
+	#endif
+
+	return senses;
+}
+
+/**
+ * @brief Samples and decodes every input for the output that is currently strobed.
+ * 
+ * @return Bitmap of the inputs that registered a keypress. Bit s corresponds to MATRIX_SENSE_PINS[s].
+ * 
+ */
+static inline matrix_word_t matrix_read_senses(void)
+{
+	Matrix_Sample_t sample;
+
+	matrix_sample_senses(&sample);
+	return matrix_decode_senses(&sample);
+}
+
+/**
+ * @brief Waits for a newly strobed output to settle before its inputs are sampled. See KB_MATRIX_SETTLE_US.
+ * 
+ */
+static inline void matrix_settle(void)
+{
+	#if (KB_MATRIX_SETTLE_US > 0)
+		_delay_us(KB_MATRIX_SETTLE_US);
+	#endif
+}
+
+/**
+ * @brief Checks if the matrix is inactive. No key may be held, bouncing, or waiting to be queued.
+ * 
+ * @return True if every key reads released and every change has been queued.
+ * 
+ */
+static inline bool matrix_is_quiet(void)
+{
+	for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++) {
+		if (matrix_raw[o] | matrix_debounced[o] | matrix_previous[o]) {
+			return false;
+		}
 	}
-	
-	/* Handle lower-bound overflow cases. E.g. (systick_wordsize_t)(5-65535) = 5 which is desired since
-	g_ms wraps around to 0 on overflow, so this still gives us the amount of time passed. This example
-	is if systick_wordsize_t definition is set to uint16_t. */
-	if ((systick_wordsize_t)(g_ms_copy - matrix_state[row][col]) >= (systick_wordsize_t)KB_DEBOUNCE_TIME_MS) 
-	{
-		return true;
+	return true;
+}
+
+/**
+ * @brief Adjusts the period of the Matrix_Scan() task to the key activity. Any activity drops the period to 
+ * KB_MATRIX_SCAN_PERIOD_MIN_MS. After every KB_MATRIX_SCAN_BACKOFF_MS without activity the period doubles, 
+ * up to KB_MATRIX_SCAN_PERIOD_MAX_MS. Does nothing until Matrix_Set_Task() is called.
+ * 
+ * @param now Timestamp of the scan that just completed.
+ * 
+ */
+static void matrix_update_scan_rate(systick_wordsize_t now)
+{
+	systick_wordsize_t period = matrix_scan_period;
+
+	if (!matrix_is_quiet()) {
+		matrix_last_activity = now;
+		period = MATRIX_SCAN_PERIOD_MIN_MS;
+	}
+	else if ((systick_wordsize_t)(now - matrix_last_activity) >= MATRIX_SCAN_BACKOFF_MS) {
+		matrix_last_activity = now; /* Start timing the next back-off step. */
+
+		if (period < MATRIX_SCAN_PERIOD_MAX_MS) {
+			period = (period > (MATRIX_SCAN_PERIOD_MAX_MS / 2U)) ? MATRIX_SCAN_PERIOD_MAX_MS : (systick_wordsize_t)(period * 2U);
+		}
+	}
+
+	if ((period != matrix_scan_period) && (matrix_task != NULL)) {
+		matrix_scan_period = period;
+		Set_Task_Frequency(matrix_task, period);
 	}
-	else 
+}
+
+#if (KB_MATRIX_IDLE_WAKE_INTERRUPT == 1)
+
+/**
+ * @brief Stops periodic scanning. matrix_task is made TASK_EVENT_DRIVEN so the scheduler no longer runs it 
+ * at all. Every output is strobed at once so a press on any key changes its input, and the inputs are armed 
+ * to interrupt on that change.
+ * 
+ */
+static void matrix_enter_idle(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		return false;
+		matrix_idle = true;
+
+		if (matrix_task != NULL) {
+			matrix_task_timing = matrix_task->timing;
+			Set_Task_Timing(matrix_task, TASK_EVENT_DRIVEN);
+		}
+
+		for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++) {
+			matrix_strobe_active(MATRIX_STROBE_PINS[o]);
+		}
+
+		for (uint8_t s = 0; s < MATRIX_NUMBER_OF_SENSES; s++) {
+			BSP_GPIO_Enable_Wake(MATRIX_SENSE_PINS[s]);
+		}
+
+		/* A key pressed since the last scan has already changed its input, so no edge would arrive. */
+		matrix_settle();
+		if (matrix_read_senses()) {
+			matrix_leave_idle();
+		}
+	}
+}
+
+/**
+ * @brief Disarms the wake interrupts and returns every output to its idle level so scanning can resume. 
+ * matrix_task goes back to its periodic timing at KB_MATRIX_SCAN_PERIOD_MIN_MS, since a key is being pressed.
+ * 
+ */
+static void matrix_leave_idle(void)
+{
+	for (uint8_t s = 0; s < MATRIX_NUMBER_OF_SENSES; s++) {
+		BSP_GPIO_Disable_Wake(MATRIX_SENSE_PINS[s]);
+	}
+
+	for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++) {
+		matrix_strobe_idle(MATRIX_STROBE_PINS[o]);
+	}
+
+	if (matrix_task != NULL) {
+		matrix_scan_period = MATRIX_SCAN_PERIOD_MIN_MS;
+		matrix_last_activity = Systick_Get_Ms();
+		Set_Task_Frequency(matrix_task, MATRIX_SCAN_PERIOD_MIN_MS);
+		Set_Task_Timing(matrix_task, matrix_task_timing);
+	}
+
+	matrix_idle = false;
+}
+
+/**
+ * @brief Wake interrupt handler. Resumes periodic scanning and signals matrix_task so the first press is 
+ * sampled on the next scheduler pass instead of a whole scan period later. The scan itself stays in the 
+ * task, so Matrix_Scan() remains the only producer of the key event queue.
+ * 
+ */
+static void matrix_wake(void)
+{
+	if (matrix_idle) {
+		matrix_leave_idle();
+
+		if (matrix_task != NULL) {
+			Signal_Task(matrix_task);
+		}
 	}
 }
+#endif
 
 /**
  * @brief Initializes the key matrix. 
@@ -66,53 +413,200 @@ void Matrix_Init(void)
 		MCUCR |= (1U << 7);
 	#endif
 
-	for (int r = 0; r < KB_NUMBER_OF_ROWS; r++) {
-		GPIO_Set_Input(g_keyboard_rowpins[r]); /* Input pullup */
+	for (uint8_t s = 0; s < MATRIX_NUMBER_OF_SENSES; s++) {
+		#if (KB_MATRIX_STROBE_LEVEL == KB_PIN_LOW)
+			BSP_GPIO_Set_Pin_Type_Input_Pullup(MATRIX_SENSE_PINS[s]);
+		#else
+			BSP_GPIO_Set_Pin_Type_Input_HiZ(MATRIX_SENSE_PINS[s]); /* External pulldowns. */
+		#endif
+	}
+
+	for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++) {
+		BSP_GPIO_Set_Pin_Type_Output_Push_Pull(MATRIX_STROBE_PINS[o]);
+		matrix_strobe_idle(MATRIX_STROBE_PINS[o]);
 	}
 
-	for (int c = 0; c < KB_NUMBER_OF_COLUMNS; c++) {
-		GPIO_Set_Output(g_keyboard_colpins[c]);
-		GPIO_Output_High(g_keyboard_colpins[c]);
+	for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++) {
+		matrix_raw[o] = 0;
+		matrix_debounced[o] = 0;
+		matrix_previous[o] = 0;
 	}
+	Debounce_Init();
+	Key_Event_Init();
+
+	#if (MATRIX_PORT_TABLES == 1)
+		/* Group the inputs by GPIO Port so each Port is only read once per strobe. */
+		sense_port_count = 0;
+
+		for (uint8_t s = 0; s < MATRIX_NUMBER_OF_SENSES; s++) {
+			uint8_t port = BSP_GET_PORT(MATRIX_SENSE_PINS[s]);
+			uint8_t p = 0;
+
+			while ((p < sense_port_count) && (sense_ports[p] != port)) {
+				p++;
+			}
+
+			if (p == sense_port_count) {
+				sense_ports[sense_port_count++] = port;
+			}
+
+			sense_port_index[s] = p;
+			sense_pin_masks[s] = (BSP_GPIO_PORT_T)(1U << BSP_GET_PIN(MATRIX_SENSE_PINS[s]));
+		}
+	#endif
+
+	#if (KB_MATRIX_IDLE_WAKE_INTERRUPT == 1)
+		/* Idle mode is only used if a press on any key can raise an interrupt. Otherwise keep scanning. */
+		matrix_idle = false;
+		matrix_wake_capable = true;
+
+		for (uint8_t s = 0; s < MATRIX_NUMBER_OF_SENSES; s++) {
+			if (!BSP_GPIO_Wake_Capable(MATRIX_SENSE_PINS[s])) {
+				matrix_wake_capable = false;
+			}
+		}
+	#endif
+}
+
+/**
+ * @brief Registers the scheduler task that runs Matrix_Scan() so the scan rate can follow key activity. 
+ * See KB_MATRIX_SCAN_PERIOD_MIN_MS in kb_config.h. The task should be created with a period of 
+ * KB_MATRIX_SCAN_PERIOD_MIN_MS.
+ * 
+ * @param task The task returned from Create_Task(). NULL keeps the period fixed.
+ * 
+ */
+void Matrix_Set_Task(Task_t * const task)
+{
+	matrix_task = task;
+	matrix_scan_period = MATRIX_SCAN_PERIOD_MIN_MS;
+	matrix_last_activity = Systick_Get_Ms();
+}
+
+#if defined(MATRIX_RUNTIME_CONFIG)
+/**
+ * @brief Changes the limits of the adaptive scan rate at run-time and restarts the task registered with 
+ * Matrix_Set_Task() at the new minimum period. Only available when MATRIX_RUNTIME_CONFIG is defined. Otherwise 
+ * the settings in kb_config.h are used.
+ * 
+ * @param period_min_ms Scan period while keys are active. See KB_MATRIX_SCAN_PERIOD_MIN_MS.
+ * @param period_max_ms Longest scan period after backing off. See KB_MATRIX_SCAN_PERIOD_MAX_MS.
+ * @param backoff_ms Time without activity before each back-off step. See KB_MATRIX_SCAN_BACKOFF_MS.
+ * 
+ */
+void Matrix_Configure_Scan_Rate(systick_wordsize_t period_min_ms, systick_wordsize_t period_max_ms, systick_wordsize_t backoff_ms)
+{
+	matrix_scan_period_min_ms = period_min_ms;
+	matrix_scan_period_max_ms = period_max_ms;
+	matrix_scan_backoff_ms = backoff_ms;
+
+	if (matrix_task != NULL) {
+		Set_Task_Frequency(matrix_task, period_min_ms);
+	}
+	Matrix_Set_Task(matrix_task);
 }
+#endif
 
 /**
- * @brief Scans the entire key matrix to detect debounced key presses.
+ * @brief Scans the entire key matrix to detect debounced key presses. Only the outputs chosen by 
+ * KB_MATRIX_STROBE_ROWS are strobed, so the number of strobes per scan is MATRIX_NUMBER_OF_STROBES.
+ * 
+ * If KB_MATRIX_IDLE_WAKE_INTERRUPT is enabled the task registered with Matrix_Set_Task() is not run while the 
+ * matrix is idle, and a direct call returns straight away.
  * 
  */
 void Matrix_Scan(void) 
 {
-	uint8_t keypress = 0;
+	#if (KB_MATRIX_IDLE_WAKE_INTERRUPT == 1)
+		if (matrix_idle) {
+			return; /* Nothing held. matrix_wake() resumes scanning on the next edge. */
+		}
+	#endif
 
-	for (int c = 0; c < KB_NUMBER_OF_COLUMNS; c++) {
-		GPIO_Output_Low(g_keyboard_colpins[c]);
+	matrix_scan_once();
 
-		for (int r = 0; r < KB_NUMBER_OF_ROWS; r++) {
+	#if (KB_MATRIX_IDLE_WAKE_INTERRUPT == 1)
+		if (matrix_wake_capable && matrix_is_quiet()) {
+			matrix_enter_idle();
+		}
+	#endif
+}
 
-			//if (matrix_state[r][c]) { /* Has debounce timer already started for this key? */
+/**
+ * @brief Strobes every output, debounces the readings and queues a Key_Event_t for every key that changed.
+ * 
+ */
+static void matrix_scan_once(void)
+{
+	Matrix_Sample_t sample;
 
-				//if (debounce_logic(r,c)) { /* Has the key been fully debounced? */
-					keypress = GPIO_Read(g_keyboard_rowpins[r]);
-					
-					if (keypress) {
-						//TODO: Store press loc, translate to keycode, store keymap in USB buffer
+	/* Software pipelined. Output o+1 is strobed as soon as output o is sampled, so decoding the sample of 
+	output o overlaps the settle time of output o+1 instead of the CPU waiting it out. */
+	matrix_strobe_active(MATRIX_STROBE_PINS[0]);
+	matrix_settle();
 
-						GPIO_Toggle(led); /* DEBUG */
-						debugpress = 1; /* DEBUG */
-					}
-					//matrix_state[r][c] = 0;
-				}
-				GPIO_Output_High(g_keyboard_colpins[c]);
+	#if (KB_MATRIX_UNROLLED_SCAN == 1)
+		UNROLL(MATRIX_NUMBER_OF_STROBES, MATRIX_SCAN_STROBE)
+	#else
+		for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++) {
+			matrix_sample_senses(&sample);
+			matrix_strobe_idle(MATRIX_STROBE_PINS[o]);
+
+			if ((o + 1U) < MATRIX_NUMBER_OF_STROBES) {
+				matrix_strobe_active(MATRIX_STROBE_PINS[o + 1U]);
+				matrix_raw[o] = matrix_decode_senses(&sample);
+				matrix_settle();
+			}
+			else {
+				matrix_raw[o] = matrix_decode_senses(&sample);
 			}
+		}
+	#endif
 
-			// else { /* Otherwise start debounce timer if initial keypress detected */
-			// 	keypress = GPIO_Read(g_keyboard_rowpins[r]);	
-			// 	if (keypress) 
-			// 	{
-			// 		matrix_state[r][c] = g_ms; /* TODO: Handle unlucky case where g_ms = 0 */
-			// 	}
-			// }
-		// }
-		
+	Debounce_Matrix(matrix_raw, matrix_debounced);
+
+	const systick_wordsize_t now = Systick_Get_Ms();
+
+	matrix_queue_events(now);
+	matrix_update_scan_rate(now);
+}
+
+/**
+ * @brief Queues a Key_Event_t for every key whose debounced state changed since it was last queued. Only 
+ * keys that changed are touched.
+ * 
+ * @param timestamp Timestamp stored in every queued event.
+ * 
+ */
+static void matrix_queue_events(systick_wordsize_t timestamp)
+{
+	Key_Event_t event;
+	event.timestamp = timestamp;
+
+	for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++) {
+		matrix_word_t changed = matrix_debounced[o] ^ matrix_previous[o];
+
+		for (uint8_t s = 0; changed; s++) {
+			const matrix_word_t mask = ((matrix_word_t)1U << s);
+
+			if (!(changed & mask)) {
+				continue;
+			}
+
+			#if (KB_MATRIX_STROBE_ROWS == 1)
+				event.row = o;
+				event.column = s;
+			#else
+				event.row = s;
+				event.column = o;
+			#endif
+			event.pressed = (matrix_debounced[o] & mask) ? 1U : 0U;
+
+			if (!Key_Event_Push(&event)) {
+				return; /* Queue full. Remaining changes stay unacknowledged and are queued on the next scan. */
+			}
+			matrix_previous[o] ^= mask;
+			changed &= (matrix_word_t)~mask;
+		}
 	}
-// }
+}
@@ -12,10 +12,41 @@
 #define MATRIX_H
 
 #include <stdint.h>
+#include "kb_config.h"
+#include "scheduler.h"
+#include "systick.h"
 
-extern uint8_t debugpress; /* TODO: DEBUGGING */
+/**
+ * @brief Number of outputs strobed and number of inputs sampled per scan. See KB_MATRIX_STROBE_ROWS in kb_config.h.
+ * 
+ */
+#if (KB_MATRIX_STROBE_ROWS == 1)
+	#define MATRIX_NUMBER_OF_STROBES			KB_NUMBER_OF_ROWS
+	#define MATRIX_NUMBER_OF_SENSES				KB_NUMBER_OF_COLUMNS
+#else
+	#define MATRIX_NUMBER_OF_STROBES			KB_NUMBER_OF_COLUMNS
+	#define MATRIX_NUMBER_OF_SENSES				KB_NUMBER_OF_ROWS
+#endif
+
+/**
+ * @brief Bitmap holding one bit per sampled input. Sized to the smallest unsigned type that fits 
+ * MATRIX_NUMBER_OF_SENSES.
+ * 
+ */
+#if (MATRIX_NUMBER_OF_SENSES <= 8)
+	typedef uint8_t matrix_word_t;
+#elif (MATRIX_NUMBER_OF_SENSES <= 16)
+	typedef uint16_t matrix_word_t;
+#else
+	typedef uint32_t matrix_word_t;
+#endif
 
 void Matrix_Init(void);
 void Matrix_Scan(void);
+void Matrix_Set_Task(Task_t * const task);
+
+#if defined(MATRIX_RUNTIME_CONFIG)
+void Matrix_Configure_Scan_Rate(systick_wordsize_t period_min_ms, systick_wordsize_t period_max_ms, systick_wordsize_t backoff_ms);
+#endif
 
 #endif /* MATRIX_H */
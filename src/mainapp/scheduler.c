@@ -2,7 +2,13 @@
  * @file scheduler.c
  * @author Ian Ress
  * @brief Software implementation of scheduler. Uses 1ms systick interrupt to keep 
- * track of time. Currently uses a round-robin non-preemptive approach.
+ * track of time. Tasks are kept in a queue per priority ordered by when they are next 
+ * due, so a scheduler pass only looks at the front of each queue. Non-preemptive.
+ * 
+ * The queues are only modified with interrupts disabled since Set_Task_Frequency() can 
+ * be called from an ISR. Timestamps are compared as elapsed time since the task last 
+ * executed, the same as before, so the 16-bit systick rolling over has no effect as 
+ * long as no task waits longer than 65535ms.
  * @date 2023-02-15
  * 
  * @copyright Copyright (c) 2023
@@ -10,19 +16,14 @@
  */
 
 #include <stddef.h>
+#include <avr/interrupt.h>
 #include <util/atomic.h>
 #include "scheduler.h"
 
-static systick_wordsize_t g_ms_copy = 0;
+static Task_t tasks[MAX_TASKS];
 
-static Task_t tasks[MAX_TASKS] =
-{
-    {NULL, 0, 0, 0},
-    {NULL, 0, 0, 0},
-    {NULL, 0, 0, 0},
-    {NULL, 0, 0, 0},
-    {NULL, 0, 0, 0},
-};
+static Task_t * queues[NUMBER_OF_TASK_PRIORITIES]; /* Task due soonest of each priority. Every queued task is linked through Task_t.next. */
+static Task_t * volatile running = NULL;            /* Task whose handler is executing. */
 
 
 /**
@@ -46,21 +47,178 @@ static int isempty(void)
 }
 
 
+/**
+ * @brief Returns how long until a task is due.
+ * 
+ * @param task The task.
+ * @param now The current systick value.
+ * 
+ * @return Time in ms until @p task is due. 0 if it is due now or overdue.
+ * 
+ */
+static systick_wordsize_t time_until_due(const Task_t * const task, systick_wordsize_t now);
+static systick_wordsize_t time_until_due(const Task_t * const task, systick_wordsize_t now)
+{
+    systick_wordsize_t elapsed = (systick_wordsize_t)(now - task->start);
+    return (elapsed >= task->freq) ? 0 : (systick_wordsize_t)(task->freq - elapsed);
+}
+
+
+/**
+ * @brief Adds a task to its priority's queue behind every task due at the same time or sooner, 
+ * so tasks due together execute in the order they became due. Must be called with interrupts 
+ * disabled.
+ * 
+ * @param task The task to add. Must not already be queued.
+ * @param now The current systick value.
+ * 
+ */
+static void enqueue(Task_t * const task, systick_wordsize_t now);
+static void enqueue(Task_t * const task, systick_wordsize_t now)
+{
+    systick_wordsize_t due = time_until_due(task, now);
+    Task_t ** link = &queues[task->priority];
+
+    while ((*link != NULL) && (time_until_due(*link, now) <= due))
+    {
+        link = &((*link)->next);
+    }
+
+    task->next = *link;
+    *link = task;
+    task->queued = true;
+}
+
+
+/**
+ * @brief Removes a task from the queue. Must be called with interrupts disabled.
+ * 
+ * @param task The task to remove. Does nothing if it is not queued.
+ * 
+ */
+static void dequeue(Task_t * const task);
+static void dequeue(Task_t * const task)
+{
+    Task_t ** link = &queues[task->priority];
+
+    while (*link != NULL)
+    {
+        if (*link == task)
+        {
+            *link = task->next;
+            break;
+        }
+        link = &((*link)->next);
+    }
+
+    task->next = NULL;
+    task->queued = false;
+}
+
+
+/**
+ * @brief Moves a task's start to when it should be considered last executed, after its 
+ * handler returns. See Task_Timing_t.
+ * 
+ * @param task The task that just executed.
+ * @param now The current systick value.
+ * 
+ */
+static void advance_start(Task_t * const task, systick_wordsize_t now);
+static void advance_start(Task_t * const task, systick_wordsize_t now)
+{
+    if ((task->timing == TASK_FIXED_DELAY) || (task->freq == 0))
+    {
+        task->start = now;
+        return;
+    }
+
+    task->start += task->freq;
+
+    if (task->timing == TASK_FIXED_RATE_SKIP)
+    {
+        systick_wordsize_t late = (systick_wordsize_t)(now - task->start);
+
+        if (late >= task->freq)
+        {
+            task->start += (systick_wordsize_t)((late / task->freq) * task->freq);
+        }
+    }
+}
+
+
+#if (SCHEDULER_TASK_STATS == 1)
+/**
+ * @brief Records one execution of a task in its statistics. Must be called with interrupts 
+ * disabled.
+ * 
+ * @param task The task that executed.
+ * @param late_us How long after the task was due its handler started.
+ * @param runtime_us How long its handler took.
+ * 
+ */
+static void record_stats(Task_t * const task, uint32_t late_us, uint32_t runtime_us);
+static void record_stats(Task_t * const task, uint32_t late_us, uint32_t runtime_us)
+{
+    Task_Stats_t * const stats = &task->stats;
+
+    if (stats->runtime_total_us > (UINT32_MAX - runtime_us))
+    {
+        stats->runtime_total_us /= 2U;
+        stats->runs /= 2U;
+    }
+
+    if ((stats->runs == 0) || (runtime_us < stats->runtime_min_us))
+    {
+        stats->runtime_min_us = runtime_us;
+    }
+
+    if (runtime_us > stats->runtime_max_us)
+    {
+        stats->runtime_max_us = runtime_us;
+    }
+
+    if (late_us > stats->late_max_us)
+    {
+        stats->late_max_us = late_us;
+    }
+
+    if ((task->freq != 0) && (late_us >= ((uint32_t)task->freq * 1000UL)))
+    {
+        stats->deadline_misses++;
+    }
+
+    stats->runtime_total_us += runtime_us;
+    stats->runs++;
+}
+#endif
+
+
 /**
  * @brief Deletes the task in the scheduler slot.
  * 
  */
 void Delete_Task(Task_t* task)
 {
-    task->handler = NULL;
-    task->start = 0;
-    task->now = 0;
-    task->freq = 0;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        dequeue(task);
+        task->handler = NULL;
+        task->start = 0;
+        task->freq = 0;
+        task->timing = TASK_FIXED_DELAY;
+        task->priority = TASK_PRIORITY_NORMAL;
+        task->signalled = false;
+        #if (SCHEDULER_TASK_STATS == 1)
+            task->stats = (Task_Stats_t){0};
+        #endif
+    }
 }
 
 
 /**
- * @brief Create a task object and adds it to an available scheduler slot.
+ * @brief Create a task object and adds it to an available scheduler slot. The task first 
+ * executes @p taskfreq ms from now.
  * 
  * @param taskhandler Callback to the task's function for the scheduler to execute. If the function requires
  * different arguments, the user should place it inside a wrapper function.
@@ -76,8 +234,49 @@ Task_t* const Create_Task(void(*task)(void), systick_wordsize_t taskfreq)
     int idx = isempty();
     if (idx >= 0)
     {
-        tasks[idx].handler = task;
-        tasks[idx].freq = taskfreq;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            tasks[idx].handler = task;
+            tasks[idx].freq = taskfreq;
+            tasks[idx].start = Systick_Get_Ms();
+            tasks[idx].timing = TASK_FIXED_DELAY;
+            tasks[idx].priority = TASK_PRIORITY_NORMAL;
+            enqueue(&tasks[idx], tasks[idx].start);
+        }
+        return &(tasks[idx]);
+    }
+    else
+    {
+        return NULL;
+    }
+}
+
+
+/**
+ * @brief Create an event-driven task and adds it to an available scheduler slot. The task has 
+ * no period. It only executes on the scheduler pass after Signal_Task() is called for it, in 
+ * priority order with every other due task.
+ * 
+ * @param taskhandler Callback to the task's function for the scheduler to execute.
+ * 
+ * @return Constant pointer where the task object is stored in the scheduler if successful. Returns NULL if 
+ * there is no room in the scheduler to add another task.
+ * 
+ */
+Task_t* Create_Event_Task(void(*task)(void))
+{
+    int idx = isempty();
+    if (idx >= 0)
+    {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            tasks[idx].handler = task;
+            tasks[idx].freq = 0;
+            tasks[idx].start = Systick_Get_Ms();
+            tasks[idx].timing = TASK_EVENT_DRIVEN;
+            tasks[idx].priority = TASK_PRIORITY_NORMAL;
+            tasks[idx].signalled = false;
+        }
         return &(tasks[idx]);
     }
     else
@@ -88,37 +287,282 @@ Task_t* const Create_Task(void(*task)(void), systick_wordsize_t taskfreq)
 
 
 /**
- * @brief Must be called periodically (e.g. within super loop). The scheduler uses a 1ms 
- * systick interrupt to keep track of time and determine which tasks are ready to execute.
- * The scheduler is non-preemptive.
+ * @brief Makes a task due now. Meant to be called from an ISR (E.g. endpoint ready, pin change 
+ * or Start of Frame). Signals are not counted. Signalling a task that is already due has no 
+ * effect, and signalling it while it executes makes it execute once more afterwards. A periodic 
+ * task keeps its period, counted from when it executes for the signal.
+ * 
+ * @param task The task returned from Create_Event_Task() or Create_Task().
  * 
  */
-void Begin_Scheduler(void)
+void Signal_Task(Task_t* const task)
 {
-    for (uint8_t i = 0; i < (uint8_t)MAX_TASKS; i++)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
     {
-        if (tasks[i].handler != NULL)
+        if (task->handler != NULL)
         {
-            if ( ((systick_wordsize_t)(tasks[i].now - tasks[i].start)) >= tasks[i].freq )
-            {
-                tasks[i].handler();
+            const systick_wordsize_t now = Systick_Get_Ms();
 
-                ATOMIC_BLOCK(ATOMIC_FORCEON) /* Get most recent systick value after task handler executes. */
+            if (task == running)
+            {
+                task->signalled = true;
+            }
+            else if (task->timing == TASK_EVENT_DRIVEN)
+            {
+                if (!task->queued)
                 {
-                    g_ms_copy = g_ms;
+                    task->start = now;
+                    enqueue(task, now);
                 }
-                tasks[i].start = g_ms_copy;
             }
-            else
+            else if (time_until_due(task, now) != 0)
+            {
+                dequeue(task);
+                task->start = (systick_wordsize_t)(now - task->freq);
+                enqueue(task, now);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Changes how often a task executes. Takes effect from the task's last execution, so lowering the 
+ * frequency value can make the task ready on the next scheduler pass. Safe to call from an ISR or from 
+ * within a task handler, including the task's own.
+ * 
+ * @param task The task returned from Create_Task().
+ * @param taskfreq How often the task should execute in ms.
+ * 
+ */
+void Set_Task_Frequency(Task_t* const task, systick_wordsize_t taskfreq)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        task->freq = taskfreq;
+
+        /* A task that is executing is queued again once its handler returns. */
+        if (task->queued)
+        {
+            dequeue(task);
+            enqueue(task, Systick_Get_Ms());
+        }
+    }
+}
+
+
+/**
+ * @brief Changes when a task is next due after it executes. See Task_Timing_t. Takes effect 
+ * from the task's next execution. Tasks are created with TASK_FIXED_DELAY, or TASK_EVENT_DRIVEN 
+ * by Create_Event_Task().
+ * 
+ * @param task The task returned from Create_Task().
+ * @param timing The timing policy.
+ * 
+ */
+void Set_Task_Timing(Task_t* const task, Task_Timing_t timing)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        task->timing = timing;
+
+        /* An idle event-driven task made periodic is not in a queue yet. */
+        if ((timing != TASK_EVENT_DRIVEN) && (task->handler != NULL) && !task->queued && (task != running))
+        {
+            task->start = Systick_Get_Ms();
+            enqueue(task, task->start);
+        }
+    }
+}
+
+
+/**
+ * @brief Changes a task's priority. Tasks are created with TASK_PRIORITY_NORMAL. Safe to call 
+ * from an ISR or from within a task handler, including the task's own.
+ * 
+ * @param task The task returned from Create_Task().
+ * @param priority The new priority.
+ * 
+ */
+void Set_Task_Priority(Task_t* const task, Task_Priority_t priority)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (task->queued)
+        {
+            dequeue(task);
+            task->priority = priority;
+            enqueue(task, Systick_Get_Ms());
+        }
+        else
+        {
+            task->priority = priority;
+        }
+    }
+}
+
+
+/**
+ * @brief Copies a task's execution statistics. Safe to call from an ISR.
+ * 
+ * @param task The task returned from Create_Task().
+ * @param stats Where the statistics are copied to.
+ * 
+ * @return True if successful. False if SCHEDULER_TASK_STATS is disabled, in which case 
+ * @p stats is not modified.
+ * 
+ */
+bool Get_Task_Stats(const Task_t* const task, Task_Stats_t* const stats)
+{
+    #if (SCHEDULER_TASK_STATS == 1)
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            *stats = task->stats;
+        }
+        return true;
+    #else
+        (void)task;
+        (void)stats;
+        return false;
+    #endif
+}
+
+
+/**
+ * @brief Clears a task's execution statistics. E.g. to measure again after changing its frequency.
+ * 
+ * @param task The task returned from Create_Task().
+ * 
+ */
+void Reset_Task_Stats(Task_t* const task)
+{
+    #if (SCHEDULER_TASK_STATS == 1)
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            task->stats = (Task_Stats_t){0};
+        }
+    #else
+        (void)task;
+    #endif
+}
+
+
+/**
+ * @brief Must be called periodically (e.g. within super loop). Executes the highest priority 
+ * task that is due. At most one task executes per call, so a high priority task that becomes 
+ * due is never kept waiting behind more than one lower priority task. When nothing is due this 
+ * only reads the systick and compares it against the front of each queue. The scheduler is 
+ * non-preemptive.
+ * 
+ */
+void Begin_Scheduler(void)
+{
+    const systick_wordsize_t now = Systick_Get_Ms(); /* Sampled once for the whole pass. */
+    Task_t * task = NULL;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (uint8_t p = 0; p < (uint8_t)NUMBER_OF_TASK_PRIORITIES; p++)
+        {
+            if ((queues[p] != NULL) && (time_until_due(queues[p], now) == 0))
+            {
+                task = queues[p];
+                dequeue(task);
+                running = task;
+                break;
+            }
+        }
+    }
+
+    if (task != NULL)
+    {
+        #if (SCHEDULER_TASK_STATS == 1)
+            Systick_Time_t begin;
+            Systick_Time_t end;
+            Systick_Get_Time(&begin);
+
+            /* Periodic tasks are due on a tick, so the sub-millisecond part of begin is all lateness. 
+             * Event-driven tasks count from the start of the tick they were signalled in. */
+            uint32_t late_us = ((uint32_t)(systick_wordsize_t)((systick_wordsize_t)(begin.ms - task->start) - task->freq) * 1000UL) + (begin.ns / 1000UL);
+        #endif
+
+        task->handler();
+
+        #if (SCHEDULER_TASK_STATS == 1)
+            Systick_Get_Time(&end);
+        #endif
+
+        const systick_wordsize_t after = Systick_Get_Ms(); /* Most recent systick value after task handler executes. */
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            /* The handler may have deleted its own task, or deleted it and created another in its slot. */
+            if ((task->handler != NULL) && !task->queued)
             {
-                ATOMIC_BLOCK(ATOMIC_FORCEON)
+                #if (SCHEDULER_TASK_STATS == 1)
+                    record_stats(task, late_us, Systick_Elapsed_Us(&begin, &end));
+                #endif
+
+                if (task->timing != TASK_EVENT_DRIVEN)
                 {
-                    g_ms_copy = g_ms;
+                    advance_start(task, after);
+
+                    if (task->signalled)
+                    {
+                        task->signalled = false;
+                        task->start = (systick_wordsize_t)(after - task->freq);
+                    }
+                    enqueue(task, after);
                 }
-                tasks[i].now = g_ms_copy;
+                else if (task->signalled)
+                {
+                    task->signalled = false;
+                    task->start = after;
+                    enqueue(task, after);
+                }
+            }
+            running = NULL;
+        }
+    }
+}
+
+
+/**
+ * @brief Sleeps the CPU until the next task is due (tickless idle). Call after Begin_Scheduler() 
+ * in the super loop. Returns straight away if a task is already due. The systick does not 
+ * interrupt while sleeping, so the CPU only wakes for the next task or for another interrupt 
+ * (E.g. USB or a matrix wake interrupt). See Systick_Sleep().
+ * 
+ * @note Must be called with interrupts enabled. Returns with interrupts enabled.
+ * 
+ */
+void Scheduler_Idle(void)
+{
+    cli(); /* Stops an ISR changing the queues between deciding to sleep and sleeping. */
+
+    systick_wordsize_t wait = SCHEDULER_IDLE_MAX_MS;
+
+    for (uint8_t p = 0; p < (uint8_t)NUMBER_OF_TASK_PRIORITIES; p++)
+    {
+        if (queues[p] != NULL)
+        {
+            systick_wordsize_t due = time_until_due(queues[p], Systick_Get_Ms());
+
+            if (due < wait)
+            {
+                wait = due;
             }
         }
     }
+
+    if (wait == 0)
+    {
+        sei();
+    }
+    else
+    {
+        Systick_Sleep(wait);
+    }
 }
 
 
@@ -2,7 +2,8 @@
  * @file scheduler.h
  * @author Ian Ress
  * @brief Software implementation of scheduler. Uses 1ms systick interrupt to keep 
- * track of time. Currently uses a round-robin non-preemptive approach.
+ * track of time. Tasks are kept in a queue per priority ordered by when they are next 
+ * due, so a scheduler pass only looks at the front of each queue. Non-preemptive.
  * @date 2023-02-15
  * 
  * @copyright Copyright (c) 2023
@@ -17,21 +18,91 @@
 #include "systick.h"
 
 /**
- * @brief The maximum number of tasks the scheduler is allowed to run.
+ * @brief The maximum number of tasks the scheduler is allowed to run. Only affects memory 
+ * and the time taken to add a task to the queue. A scheduler pass takes the same time 
+ * regardless.
  * 
  */
 #define MAX_TASKS                               5 
 
+/**
+ * @brief The longest Scheduler_Idle() sleeps when there are no tasks. Systick_Sleep() 
+ * limits this further to what the systick timer can count.
+ * 
+ */
+#define SCHEDULER_IDLE_MAX_MS                   1000
+
+/**
+ * @brief Setting this to 1 records Task_Stats_t for every task. Costs two Systick_Get_Time() 
+ * reads per task execution. Disabled by default, which removes the statistics entirely. The host 
+ * build enables it from CMakeLists.txt for the benchmarks.
+ * 
+ */
+#ifndef SCHEDULER_TASK_STATS
+#define SCHEDULER_TASK_STATS                    0
+#endif
+
+/**
+ * @brief Execution statistics of a task. Read with Get_Task_Stats().
+ * 
+ */
 typedef struct {
+    uint32_t runs;              /* Number of executions recorded. */
+    uint32_t runtime_min_us;    /* Shortest handler runtime. */
+    uint32_t runtime_max_us;    /* Longest handler runtime. */
+    uint32_t runtime_total_us;  /* Sum of handler runtimes. Halved along with runs before it overflows, so total / runs stays the average. */
+    uint32_t late_max_us;       /* Worst start jitter. Longest time from when the task was due until its handler started. */
+    uint32_t deadline_misses;   /* Executions that started a whole period or more late, so an execution was lost or pushed into the next period. */
+} Task_Stats_t;
+
+/**
+ * @brief When a task is next due after it executes. Set with Set_Task_Timing().
+ * 
+ */
+typedef enum {
+    TASK_FIXED_DELAY = 0,       /* Default. Due freq ms after the handler last returned. Periods stretch by the handler's runtime and any scheduling delay. */
+    TASK_FIXED_RATE_CATCH_UP,   /* Due exactly freq ms after it was last due. Missed executions run back to back until the task is on time again. */
+    TASK_FIXED_RATE_SKIP,       /* Due exactly freq ms after it was last due. Missed executions are dropped so the task stays in phase. */
+    TASK_EVENT_DRIVEN           /* Never due on its own. Due as soon as Signal_Task() is called, E.g. from an ISR. See Create_Event_Task(). */
+} Task_Timing_t;
+
+/**
+ * @brief Task priority. When tasks of different priorities are due at the same time the 
+ * higher priority task executes first. Set with Set_Task_Priority().
+ * 
+ */
+typedef enum {
+    TASK_PRIORITY_HIGH = 0,     /* Time-critical. E.g. the matrix scan and HID report. */
+    TASK_PRIORITY_NORMAL,       /* Default. */
+    TASK_PRIORITY_LOW,          /* Housekeeping. */
+    NUMBER_OF_TASK_PRIORITIES
+} Task_Priority_t;
+
+typedef struct Task_t {
     void (*handler)(void);      /* Task handler function. */
-    systick_wordsize_t start;   /* Timestamp of when task last executed. */
-    systick_wordsize_t now;     /* The current timestamp. */
+    systick_wordsize_t start;   /* Timestamp of when task last executed. For fixed rate tasks, when it was last due. */
     systick_wordsize_t freq;    /* Frequency task should execute at in ms. Example: freq = 5 executes the task every 5ms. */
+    struct Task_t * next;       /* Task due after this one. NULL if this is the last task in the queue. */
+    bool queued;                /* True while the task is in the queue. False while it executes. */
+    Task_Timing_t timing;       /* When the task is next due after it executes. */
+    Task_Priority_t priority;   /* Which queue the task is in. */
+    volatile bool signalled;    /* Signal_Task() was called while the task was executing. It executes again afterwards. */
+#if (SCHEDULER_TASK_STATS == 1)
+    Task_Stats_t stats;         /* Execution statistics. */
+#endif
 } Task_t;
 
 Task_t* const Create_Task(void(*task)(void), systick_wordsize_t taskfreq);
+Task_t* Create_Event_Task(void(*task)(void));
+void Signal_Task(Task_t* const task);
 void Delete_Task(Task_t* task);
+void Set_Task_Frequency(Task_t* const task, systick_wordsize_t taskfreq);
+void Set_Task_Timing(Task_t* const task, Task_Timing_t timing);
+void Set_Task_Priority(Task_t* const task, Task_Priority_t priority);
+bool Get_Task_Stats(const Task_t* const task, Task_Stats_t* const stats);
+void Reset_Task_Stats(Task_t* const task);
 void Begin_Scheduler(void);
+void Scheduler_Idle(void);
 void Clear_Scheduler(void);
 
 #endif /* SCHEDULER_H */
@@ -14,6 +14,9 @@
  */
 
 #include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "bsp_sleep.h"
+#include "bsp_tim1.h"
 #include "systick.h"
 #include "timer.h"
 
@@ -21,15 +24,34 @@
 static const timer1_t* const systick = &TIM1; 
 
 volatile systick_wordsize_t g_ms = 0;
+volatile systick_wordsize_t g_ms_epoch = 0;
+volatile bool g_ms_stretched = false;
+
+static uint16_t tick_top = 0;                       /* TIM1 TOP value for one SYSTICK_PERIOD_MS tick. */
+static uint32_t ns_per_count = 0;                   /* Duration of one TIM1 count in ns. */
+static volatile systick_wordsize_t tick_ms = SYSTICK_PERIOD_MS; /* Time covered by the next tick. Raised by Systick_Sleep(). */
 
 /**
- * @brief ISR that executes each timer tick.
+ * @brief ISR that executes each timer tick. Ends a stretched tick started by Systick_Sleep().
  * 
  */
 static void Systick_ISR(void);
 static void Systick_ISR(void) 
 {
-    g_ms++;
+    systick_wordsize_t ms = (systick_wordsize_t)(g_ms + tick_ms);
+
+    if (ms < g_ms)
+    {
+        g_ms_epoch++;
+    }
+    g_ms = ms;
+
+    if (tick_ms != SYSTICK_PERIOD_MS)
+    {
+        tick_ms = SYSTICK_PERIOD_MS;
+        g_ms_stretched = false;
+        BSP_TIM1_Set_Top(tick_top);
+    }
     // if (g_ms == 0) 
     // {
     //     g_ms = 1;
@@ -46,6 +68,8 @@ static void Systick_ISR(void)
 void Systick_Init(void) 
 {
     systick->init(SYSTICK_PERIOD_MS);
+    tick_top = BSP_TIM1_Get_Top();
+    ns_per_count = (SYSTICK_PERIOD_MS * 1000000UL) / ((uint32_t)tick_top + 1U);
 }
 
 
@@ -55,7 +79,7 @@ void Systick_Init(void)
  */
 void Systick_Start(void) 
 {
-    systick->start(systick_isr);
+    systick->start(Systick_ISR);
 }
 
 
@@ -67,3 +91,111 @@ void Systick_Stop(void)
 {
     systick->stop();
 }
+
+
+/**
+ * @brief Sleeps the CPU for up to @p ms milliseconds without waking for the ticks in between. The 
+ * current tick is stretched to end @p ms from the start of the tick TIM1 is in, so a sleep started 
+ * part way through a tick still ends on a tick boundary and g_ms stays in phase. Any other interrupt 
+ * ends the sleep early, in which case the stretched tick is cut short to end on the next tick 
+ * boundary. TCNT1 is never written, so no counts are lost however long that takes, and the systick 
+ * ISR adds the whole ticks that passed when the tick ends. Until then Systick_Get_Ms() reads the 
+ * time from TIM1, so an ISR that wakes the CPU still sees the current time.
+ * 
+ * @param ms How long to sleep. Limited to as many ticks as fit in TIM1's 16-bit counter. 0 or 1 
+ * sleeps until the next tick.
+ * 
+ * @warning Must be called with interrupts disabled. Returns with interrupts enabled.
+ * 
+ */
+void Systick_Sleep(systick_wordsize_t ms)
+{
+    const uint32_t counts_per_tick = (uint32_t)tick_top + 1U;
+    const systick_wordsize_t max_ticks = (systick_wordsize_t)(0x10000UL / counts_per_tick);
+    systick_wordsize_t ticks = (systick_wordsize_t)(ms / SYSTICK_PERIOD_MS);
+
+    if (!BSP_TIM1_Compare_Pending())
+    {
+        /* A tick cut short by an earlier early wake already covers the ticks that passed before it. */
+        if (tick_ms != SYSTICK_PERIOD_MS)
+        {
+            ticks += (systick_wordsize_t)(BSP_TIM1_Get_Count() / counts_per_tick);
+        }
+
+        if (ticks > max_ticks)
+        {
+            ticks = max_ticks;
+        }
+
+        /* Only ever raised here, so TOP stays above TCNT1. */
+        if (ticks > (systick_wordsize_t)(tick_ms / SYSTICK_PERIOD_MS))
+        {
+            tick_ms = (systick_wordsize_t)(ticks * SYSTICK_PERIOD_MS);
+            g_ms_stretched = true;
+            BSP_TIM1_Set_Top((uint16_t)((ticks * counts_per_tick) - 1U));
+        }
+    }
+
+    BSP_Sleep_Idle();
+
+    cli();
+    if ((tick_ms != SYSTICK_PERIOD_MS) && !BSP_TIM1_Compare_Pending())
+    {
+        /* Woken early by another interrupt. End the stretched tick on the next tick boundary. */
+        ticks = (systick_wordsize_t)((BSP_TIM1_Get_Count() / counts_per_tick) + 1U);
+
+        if (ticks < (systick_wordsize_t)(tick_ms / SYSTICK_PERIOD_MS))
+        {
+            uint16_t top = (uint16_t)((ticks * counts_per_tick) - 1U);
+
+            tick_ms = (systick_wordsize_t)(ticks * SYSTICK_PERIOD_MS);
+            BSP_TIM1_Set_Top(top);
+
+            /* TCNT1 kept counting while the boundary was worked out. If it already passed the new TOP it 
+             * would run on to 0xFFFF, so move TOP on to the following boundary instead. */
+            while (!BSP_TIM1_Compare_Pending() && (BSP_TIM1_Get_Count() > top))
+            {
+                top = (uint16_t)(top + counts_per_tick);
+                tick_ms = (systick_wordsize_t)(tick_ms + SYSTICK_PERIOD_MS);
+                BSP_TIM1_Set_Top(top);
+            }
+        }
+    }
+    sei();
+}
+
+
+/**
+ * @brief Reads the current time with the resolution of one TIM1 count by combining the extended 
+ * millisecond epoch with how far TIM1 is through the current tick. E.g. 500ns if TIM1 runs at 
+ * 2MHz. Safe to call from an ISR.
+ * 
+ * @param time Where the current time is stored.
+ * 
+ */
+void Systick_Get_Time(Systick_Time_t * const time)
+{
+    const uint32_t counts_per_tick = (uint32_t)tick_top + 1U;
+    uint32_t ms;
+    uint16_t count;
+
+    /* Interrupts stay disabled only for the TIM1 read, since TCNT1 shares the TEMP register. */
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ms = ((uint32_t)g_ms_epoch << 16) | g_ms;
+        count = BSP_TIM1_Get_Count();
+
+        /* The tick ended but its ISR has not run yet. The counter already restarted from 0. */
+        if (BSP_TIM1_Compare_Pending() && (count < (uint16_t)(counts_per_tick / 2U)))
+        {
+            ms += tick_ms;
+        }
+    }
+
+    /* A tick stretched by Systick_Sleep() covers several ticks worth of counts. */
+    ms += (count / counts_per_tick) * SYSTICK_PERIOD_MS;
+    count = (uint16_t)(count % counts_per_tick);
+
+    time->ms = ms;
+    time->ns = count * ns_per_count;
+}
@@ -16,17 +16,128 @@
 #ifndef SYSTICK_H
 #define SYSTICK_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #define SYSTICK_PERIOD_MS                       1
 
 typedef uint16_t systick_wordsize_t;
 
+/**
+ * @brief A point in time with sub-microsecond resolution. See Systick_Get_Time().
+ * 
+ */
+typedef struct {
+    uint32_t ms;                /* Extended millisecond epoch at that time. See Systick_Get_Ms32(). */
+    uint32_t ns;                /* Nanoseconds since the epoch last incremented. Resolution is one TIM1 count. */
+} Systick_Time_t;
+
 extern volatile systick_wordsize_t g_ms;
+extern volatile systick_wordsize_t g_ms_epoch;  /* Number of times g_ms has rolled over. Upper half of Systick_Get_Ms32(). */
+extern volatile bool g_ms_stretched;            /* True while Systick_Sleep() stretches the current tick. g_ms lags behind until it ends. */
 
 void Systick_Init(void);
 void Systick_Start(void);
 void Systick_Stop(void);
+void Systick_Sleep(systick_wordsize_t ms);
+void Systick_Get_Time(Systick_Time_t * const time);
+
+/**
+ * @brief Reads g_ms without disabling interrupts. g_ms is wider than the CPU's registers, so the 
+ * systick ISR can change it part way through a read. It is read twice and only accepted once both 
+ * reads agree, which can only fail while an ISR lands between them. Safe to call from an ISR.
+ * 
+ * While Systick_Sleep() stretches a tick, g_ms only catches up once the tick ends. An ISR that wakes 
+ * the CPU during it reads the time from TIM1 instead with Systick_Get_Time().
+ * 
+ * @return The current systick value.
+ * 
+ */
+static inline systick_wordsize_t Systick_Get_Ms(void);
+static inline systick_wordsize_t Systick_Get_Ms(void)
+{
+    systick_wordsize_t ms;
+
+    if (g_ms_stretched)
+    {
+        Systick_Time_t time;
+        Systick_Get_Time(&time);
+        return (systick_wordsize_t)time.ms;
+    }
+
+    do
+    {
+        ms = g_ms;
+    } while (ms != g_ms);
+
+    return ms;
+}
+
+
+/**
+ * @brief Reads the 32-bit extended millisecond epoch without disabling interrupts. It is g_ms with 
+ * g_ms_epoch as the upper half, so it only rolls over every ~49.7 days. Retries the same way as 
+ * Systick_Get_Ms() if the systick ISR rolls g_ms over part way through, and also reads a stretched 
+ * tick from TIM1. Safe to call from an ISR.
+ * 
+ * @return Milliseconds since the systick started.
+ * 
+ */
+static inline uint32_t Systick_Get_Ms32(void);
+static inline uint32_t Systick_Get_Ms32(void)
+{
+    systick_wordsize_t epoch;
+    systick_wordsize_t ms;
+
+    if (g_ms_stretched)
+    {
+        Systick_Time_t time;
+        Systick_Get_Time(&time);
+        return time.ms;
+    }
+
+    do
+    {
+        epoch = g_ms_epoch;
+        ms = Systick_Get_Ms();
+    } while (epoch != g_ms_epoch);
+
+    return ((uint32_t)epoch << 16) | ms;
+}
+
+
+
+/**
+ * @brief Returns the time between two Systick_Get_Time() readings.
+ * 
+ * @param from The earlier reading.
+ * @param to The later reading.
+ * 
+ * @return Microseconds from @p from to @p to. Correct for readings up to ~71 minutes apart.
+ * 
+ */
+static inline uint32_t Systick_Elapsed_Us(const Systick_Time_t * const from, const Systick_Time_t * const to);
+static inline uint32_t Systick_Elapsed_Us(const Systick_Time_t * const from, const Systick_Time_t * const to)
+{
+    return ((to->ms - from->ms) * 1000UL) + (to->ns / 1000UL) - (from->ns / 1000UL);
+}
+
+
+/**
+ * @brief Returns the time between two Systick_Get_Time() readings with full resolution. E.g. for 
+ * profiling a single function.
+ * 
+ * @param from The earlier reading.
+ * @param to The later reading.
+ * 
+ * @return Nanoseconds from @p from to @p to. Correct for readings up to ~4.29 seconds apart.
+ * 
+ */
+static inline uint32_t Systick_Elapsed_Ns(const Systick_Time_t * const from, const Systick_Time_t * const to);
+static inline uint32_t Systick_Elapsed_Ns(const Systick_Time_t * const from, const Systick_Time_t * const to)
+{
+    return ((to->ms - from->ms) * 1000000UL) + to->ns - from->ns;
+}
 
 
 #endif /* SYSTICK_H */
@@ -0,0 +1,69 @@
+/**
+ * @file unroll.h
+ * @author Ian Ress
+ * @brief Preprocessor loop unrolling. UNROLL(N, M) expands to M(0) M(1) ... M(N-1) so every iteration 
+ * uses a literal index. Used where a loop over compile-time constant tables must fold down to 
+ * individual instructions instead of indexing the table at run time.
+ * 
+ * N must expand to a plain decimal literal between 1 and UNROLL_MAX inclusive. E.g. 4 works but (4) 
+ * or 2*2 do not, since the value is pasted onto UNROLL_ to select the expansion.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef UNROLL_H
+#define UNROLL_H
+
+/**
+ * @brief The largest iteration count UNROLL() supports.
+ * 
+ */
+#define UNROLL_MAX                              32
+
+/**
+ * @brief Expands to M(0) M(1) ... M(N-1).
+ * 
+ * @param N Number of iterations. Must expand to a plain decimal literal between 1 and UNROLL_MAX inclusive.
+ * @param M Macro taking a single index argument.
+ * 
+ */
+#define UNROLL(N, M)                            UNROLL_EXPAND(N, M)
+#define UNROLL_EXPAND(N, M)                     UNROLL_##N(M)
+
+#define UNROLL_1(M)                             M(0)
+#define UNROLL_2(M)                             UNROLL_1(M) M(1)
+#define UNROLL_3(M)                             UNROLL_2(M) M(2)
+#define UNROLL_4(M)                             UNROLL_3(M) M(3)
+#define UNROLL_5(M)                             UNROLL_4(M) M(4)
+#define UNROLL_6(M)                             UNROLL_5(M) M(5)
+#define UNROLL_7(M)                             UNROLL_6(M) M(6)
+#define UNROLL_8(M)                             UNROLL_7(M) M(7)
+#define UNROLL_9(M)                             UNROLL_8(M) M(8)
+#define UNROLL_10(M)                            UNROLL_9(M) M(9)
+#define UNROLL_11(M)                            UNROLL_10(M) M(10)
+#define UNROLL_12(M)                            UNROLL_11(M) M(11)
+#define UNROLL_13(M)                            UNROLL_12(M) M(12)
+#define UNROLL_14(M)                            UNROLL_13(M) M(13)
+#define UNROLL_15(M)                            UNROLL_14(M) M(14)
+#define UNROLL_16(M)                            UNROLL_15(M) M(15)
+#define UNROLL_17(M)                            UNROLL_16(M) M(16)
+#define UNROLL_18(M)                            UNROLL_17(M) M(17)
+#define UNROLL_19(M)                            UNROLL_18(M) M(18)
+#define UNROLL_20(M)                            UNROLL_19(M) M(19)
+#define UNROLL_21(M)                            UNROLL_20(M) M(20)
+#define UNROLL_22(M)                            UNROLL_21(M) M(21)
+#define UNROLL_23(M)                            UNROLL_22(M) M(22)
+#define UNROLL_24(M)                            UNROLL_23(M) M(23)
+#define UNROLL_25(M)                            UNROLL_24(M) M(24)
+#define UNROLL_26(M)                            UNROLL_25(M) M(25)
+#define UNROLL_27(M)                            UNROLL_26(M) M(26)
+#define UNROLL_28(M)                            UNROLL_27(M) M(27)
+#define UNROLL_29(M)                            UNROLL_28(M) M(28)
+#define UNROLL_30(M)                            UNROLL_29(M) M(29)
+#define UNROLL_31(M)                            UNROLL_30(M) M(30)
+#define UNROLL_32(M)                            UNROLL_31(M) M(31)
+
+#endif /* UNROLL_H */
@@ -230,6 +230,33 @@ static const HsmState USBHID_Device_Hsm_Configured_State =
 
 
 
+/**
+ * Transition Paths. Every transition the State Handlers make is listed here so the Dispatcher 
+ * never has to determine the Exit and Entry Events at run-time. This keeps the time spent in a
+ * transition short and fixed during enumeration. Each path must be updated if the State
+ * hierarchy above changes. See HsmTranPath in hsm.h.
+ */
+static const HsmState * const USBHID_Device_Hsm_USB_Superstate_Path[] = {&USBHID_Device_Hsm_USB_Superstate, (HsmState *)0};
+static const HsmState * const USBHID_Device_Hsm_Hard_Error_State_Path[] = {&USBHID_Device_Hsm_Hard_Error_State, (HsmState *)0};
+static const HsmState * const USBHID_Device_Hsm_Default_State_Path[] = {&USBHID_Device_Hsm_Default_State, (HsmState *)0};
+static const HsmState * const USBHID_Device_Hsm_Address_State_Path[] = {&USBHID_Device_Hsm_Address_State, (HsmState *)0};
+static const HsmState * const USBHID_Device_Hsm_Configured_State_Path[] = {&USBHID_Device_Hsm_Configured_State, (HsmState *)0};
+static const HsmState * const USBHID_Device_Hsm_USB_Reset_Entry_Path[] = {&USBHID_Device_Hsm_USB_Superstate, &USBHID_Device_Hsm_Default_State, (HsmState *)0};
+
+static const HsmTranPath USBHID_Device_Hsm_Tran_Paths[] =
+{
+    /* Source                               Target                                  Exit Path                                   Entry Path */
+    {&USBHID_Device_Hsm_USB_Superstate,     &USBHID_Device_Hsm_Hard_Error_State,    USBHID_Device_Hsm_USB_Superstate_Path,      USBHID_Device_Hsm_Hard_Error_State_Path},   /* POWER_CYCLE_REQ */
+    {&USBHID_Device_Hsm_USB_Superstate,     &USBHID_Device_Hsm_Default_State,       USBHID_Device_Hsm_USB_Superstate_Path,      USBHID_Device_Hsm_USB_Reset_Entry_Path},    /* HOST_RESET_REQ, SOFTWARE_RESET_REQ */
+    {&USBHID_Device_Hsm_Default_State,      &USBHID_Device_Hsm_Address_State,       USBHID_Device_Hsm_Default_State_Path,       USBHID_Device_Hsm_Address_State_Path},      /* SET_ADDRESS */
+    {&USBHID_Device_Hsm_Address_State,      &USBHID_Device_Hsm_Default_State,       USBHID_Device_Hsm_Address_State_Path,       USBHID_Device_Hsm_Default_State_Path},      /* SET_ADDRESS to 0 */
+    {&USBHID_Device_Hsm_Address_State,      &USBHID_Device_Hsm_Configured_State,    USBHID_Device_Hsm_Address_State_Path,       USBHID_Device_Hsm_Configured_State_Path},   /* SET_CONFIGURATION */
+    {&USBHID_Device_Hsm_Configured_State,   &USBHID_Device_Hsm_Address_State,       USBHID_Device_Hsm_Configured_State_Path,    USBHID_Device_Hsm_Address_State_Path},      /* SET_CONFIGURATION to 0 */
+    {(HsmState *)0}
+};
+
+
+
 /**
  * State Handler Function Definitions.
  */
@@ -931,6 +958,7 @@ bool USBHID_Device_Hsm_Default_Ctor(USBHID_Device_Hsm * const me)
         me->Address                                     = 0;
         me->Configuration_Index                         = 0;
         Hsm_Ctor((Hsm *)me, USBHID_Device_Hsm_Top_State_Hndlr);
+        Hsm_Set_Tran_Paths((Hsm *)me, USBHID_Device_Hsm_Tran_Paths);
         success = true;
     }
     return success;
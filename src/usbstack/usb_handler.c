@@ -255,6 +255,20 @@ void EVENT_USB_Device_StartOfFrame(void)
 	HID_Device_MillisecondElapsed(&Keyboard_HID_Interface);
 }
 
+/** Fills in a Keyboard HID report from the key events queued by the matrix scan since the last report.
+ *
+ *  @param KeyboardReport  Report to fill in
+ */
+static void BuildKeyboardReport(USB_KeyboardReport_Data_t* const KeyboardReport)
+{
+	Keyboard_Report_t Report;
+
+	Keyboard_Report_Build(&Report);
+
+	KeyboardReport->Modifier = Report.modifiers;
+	memcpy(KeyboardReport->KeyCode, Report.keycodes, sizeof(KeyboardReport->KeyCode));
+}
+
 /** HID class driver callback function for the creation of HID reports to the host.
  *
  *  @param HIDInterfaceInfo  Pointer to the HID class interface configuration structure being referenced
@@ -273,10 +287,7 @@ bool CALLBACK_HID_Device_CreateHIDReport(USB_ClassInfo_HID_Device_t* const HIDIn
 {
 	USB_KeyboardReport_Data_t* KeyboardReport = (USB_KeyboardReport_Data_t*)ReportData;
 
-	if (debugpress) {
-		KeyboardReport->KeyCode[0] = HID_KEYBOARD_SC_A;
-		debugpress = 0;
-	}
+	BuildKeyboardReport(KeyboardReport);
 
 	*ReportSize = sizeof(USB_KeyboardReport_Data_t);
 	return false;
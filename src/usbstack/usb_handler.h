@@ -9,6 +9,7 @@
 #include <avr/interrupt.h>
 #include <stdbool.h>
 #include <string.h>
+#include "keyboard_report.h"
 #include "matrix.h"
 #include "LUFA/Drivers/USB/USB.h"
 #include "LUFA/Platform/Platform.h"
@@ -58,6 +58,60 @@
 #define KB_SET_OUTPUT									1
 
 
+/**
+ * @brief Diode Cathode faces the Rows. Current flows from the Columns to the Rows through the diode.
+ * 
+ * @attention Do not use in Application Code. Meant for use only within kb_config.h
+ * 
+ */
+#define COL2ROW											0
+
+
+/**
+ * @brief Diode Cathode faces the Columns. Current flows from the Rows to the Columns through the diode.
+ * 
+ * @attention Do not use in Application Code. Meant for use only within kb_config.h
+ * 
+ */
+#define ROW2COL											1
+
+
+/**
+ * @brief Deferred Debounce. A key only registers once it has read the same state for KB_DEBOUNCE_TIME_MS.
+ * 
+ * @attention Do not use in Application Code. Meant for use only within kb_config.h
+ * 
+ */
+#define KB_DEBOUNCE_DEFERRED							0
+
+
+/**
+ * @brief Vertical Counter Debounce. A key only registers once it has read the same state for 4 consecutive scans.
+ * 
+ * @attention Do not use in Application Code. Meant for use only within kb_config.h
+ * 
+ */
+#define KB_DEBOUNCE_VERTICAL_COUNTER					1
+
+
+/**
+ * @brief Eager Debounce. A key registers on its first edge and is then locked out for KB_DEBOUNCE_TIME_MS.
+ * 
+ * @attention Do not use in Application Code. Meant for use only within kb_config.h
+ * 
+ */
+#define KB_DEBOUNCE_EAGER								2
+
+
+/**
+ * @brief Asymmetric Debounce. Deferred Debounce with separate windows for presses and releases.
+ * 
+ * @attention Do not use in Application Code. Meant for use only within kb_config.h
+ * 
+ */
+#define KB_DEBOUNCE_ASYMMETRIC							3
+
+
 
 /*----------------------------------------------------------------------------------------------------------------*/
 /*------------------------------------------ USER CONFIGURES KEYBOARD HERE ---------------------------------------*/
@@ -69,7 +123,168 @@
  * will occur.
  * 
  */
-#define KB_DEBOUNCE_TIME_MS								5000
+#define KB_DEBOUNCE_TIME_MS								5
+
+
+/**
+ * @brief The debounce algorithm. Set to KB_DEBOUNCE_DEFERRED, KB_DEBOUNCE_EAGER, KB_DEBOUNCE_ASYMMETRIC or 
+ * KB_DEBOUNCE_VERTICAL_COUNTER. The latency listed for each is the worst case from a clean key edge to the 
+ * debounced state changing, where T is the scan period.
+ * 
+ * KB_DEBOUNCE_DEFERRED times each bouncing key with the systick using KB_DEBOUNCE_TIME_MS and 
+ * KB_DEBOUNCE_MAX_BOUNCING_KEYS. Press and release latency: KB_DEBOUNCE_TIME_MS + T.
+ * 
+ * KB_DEBOUNCE_EAGER reports a key on the first scan that sees it change and then ignores that key for 
+ * KB_DEBOUNCE_TIME_MS while its contacts bounce. Press and release latency: T, independent of the debounce 
+ * window. The trade-off is that a single noisy reading registers as a keypress, and a key cannot change 
+ * state twice within KB_DEBOUNCE_TIME_MS.
+ * 
+ * KB_DEBOUNCE_ASYMMETRIC works like KB_DEBOUNCE_DEFERRED but waits KB_DEBOUNCE_PRESS_TIME_MS before 
+ * registering a press and KB_DEBOUNCE_RELEASE_TIME_MS before registering a release. Press latency: 
+ * KB_DEBOUNCE_PRESS_TIME_MS + T. Release latency: KB_DEBOUNCE_RELEASE_TIME_MS + T.
+ * 
+ * KB_DEBOUNCE_VERTICAL_COUNTER debounces a whole Row/Column at once with bitwise counters and never reads the 
+ * systick. Its cost per scan is constant so it suits high scan rates. The debounce window is 4 scan periods,
+ * so KB_DEBOUNCE_TIME_MS and KB_DEBOUNCE_MAX_BOUNCING_KEYS are ignored. E.g. scanning every 1ms gives a 4ms window.
+ * Press and release latency: 4T.
+ * 
+ * @warning A compilation error will occur if this is not set to one of the values above.
+ * 
+ */
+#define KB_DEBOUNCE_ALGORITHM							KB_DEBOUNCE_DEFERRED
+
+
+/**
+ * @brief Time in milliseconds a key must read as pressed before the press registers. Only used when 
+ * KB_DEBOUNCE_ALGORITHM is set to KB_DEBOUNCE_ASYMMETRIC. Press bounce is usually shorter than release 
+ * bounce on most switches, so this can be set lower than KB_DEBOUNCE_RELEASE_TIME_MS to cut press latency.
+ * 
+ */
+#define KB_DEBOUNCE_PRESS_TIME_MS						2
+
+
+/**
+ * @brief Time in milliseconds a key must read as released before the release registers. Only used when 
+ * KB_DEBOUNCE_ALGORITHM is set to KB_DEBOUNCE_ASYMMETRIC.
+ * 
+ */
+#define KB_DEBOUNCE_RELEASE_TIME_MS						5
+
+
+/**
+ * @brief The maximum number of keys that can be debounced at the same time. A debounce timer is only held 
+ * while a key's reading differs from its debounced state, so this only needs to cover keys that change 
+ * within the same KB_DEBOUNCE_TIME_MS window. Any additional keys are debounced once a timer frees up. Not used 
+ * by KB_DEBOUNCE_VERTICAL_COUNTER.
+ * 
+ * @warning This must be between 1 and 254 inclusive. A compilation error will occur if this is not followed.
+ * 
+ */
+#define KB_DEBOUNCE_MAX_BOUNCING_KEYS					10
+
+
+/**
+ * @brief Number of key change events that can be waiting between the Matrix Scanning Algorithm and the USB HID 
+ * report. Each scan queues one event per key whose debounced state changed, and each HID report drains the 
+ * queue. If the queue is full the change is held back and queued again on the next scan, so no presses are lost.
+ * 
+ * @warning This must be a power of two between 2 and 128 inclusive. A compilation error will occur if this is not followed.
+ * 
+ */
+#define KB_KEY_EVENT_QUEUE_SIZE							16
+
+
+/**
+ * @brief Fastest Matrix Scanning period in milliseconds. The Matrix_Scan() task runs at this period while any 
+ * key is held, bouncing, or was changed within the last KB_MATRIX_SCAN_BACKOFF_MS. Only used once the task is 
+ * registered with Matrix_Set_Task().
+ * 
+ * @warning This must be at least 1. A compilation error will occur if this is not followed.
+ * 
+ */
+#define KB_MATRIX_SCAN_PERIOD_MIN_MS					1
+
+
+/**
+ * @brief Slowest Matrix Scanning period in milliseconds. After every KB_MATRIX_SCAN_BACKOFF_MS without key 
+ * activity the scan period doubles until it reaches this value. Setting this equal to KB_MATRIX_SCAN_PERIOD_MIN_MS 
+ * keeps the scan rate fixed. A slower idle rate adds up to this much latency to the first press after a pause, 
+ * unless KB_MATRIX_IDLE_WAKE_INTERRUPT is used.
+ * 
+ * @warning This must be greater than or equal to KB_MATRIX_SCAN_PERIOD_MIN_MS. A compilation error will occur 
+ * if this is not followed.
+ * 
+ */
+#define KB_MATRIX_SCAN_PERIOD_MAX_MS					16
+
+
+/**
+ * @brief Time in milliseconds without key activity before each step down in scan rate. See 
+ * KB_MATRIX_SCAN_PERIOD_MAX_MS.
+ * 
+ * @warning This must be at least 1. A compilation error will occur if this is not followed.
+ * 
+ */
+#define KB_MATRIX_SCAN_BACKOFF_MS						100
+
+
+/**
+ * @brief Number of Rows on the Keyboard. This MUST be equal to the number of pins listed in ROW_PINS.
+ * 
+ */
+#define KB_NUMBER_OF_ROWS								4
+
+
+/**
+ * @brief Number of Columns on the Keyboard. This MUST be equal to the number of pins listed in COLUMN_PINS.
+ * 
+ */
+#define KB_NUMBER_OF_COLUMNS							14
+
+
+/**
+ * @brief Controls how the Matrix Scanning Algorithm samples the inputs after each output is strobed. Setting 
+ * this to 1 reads each GPIO Port the inputs are connected to only once per strobe and extracts every input 
+ * from that single reading. Setting this to 0 reads every input pin individually. For example if all four 
+ * Rows are connected to PD0 - PD3, setting this to 1 takes one PIND reading per Column instead of four.
+ * 
+ * @note The Port and Pin masks are built once from ROW_PINS within Matrix_Init(). Leaving this set to 1 is 
+ * recommended unless every input is on its own Port, in which case both settings perform the same.
+ * 
+ * @warning This can only be set to either 0 or 1. A compilation error will occur if this is not followed.
+ * 
+ */
+#define KB_MATRIX_PORT_WIDE_SAMPLING					1
+
+
+/**
+ * @brief Extra time in microseconds the Matrix Scanning Algorithm waits after strobing an output before sampling 
+ * the inputs. Covers the time the Row/Column trace and the input pullups/pulldowns need to reach a valid level, 
+ * which depends on the Keyboard PCB. The scan is pipelined so the previous output's readings are decoded right 
+ * after the next output is strobed. This only needs to cover whatever settle time remains after that, and can 
+ * be set to 0 if the decode time is already enough. The first output of every scan waits the full value.
+ * 
+ * @warning This cannot be negative. A compilation error will occur if this is not followed.
+ * 
+ */
+#define KB_MATRIX_SETTLE_US								1
+
+
+/**
+ * @brief Setting this to 1 builds the Matrix Scanning Algorithm fully unrolled over ROW_PINS and COLUMN_PINS 
+ * instead of looping over them. Every pin is then a compile-time constant so each strobe and each input read 
+ * compiles down to a single instruction (SBI/CBI/SBIC on ATMega16U4/ATMega32U4). Costs more flash per key. 
+ * KB_MATRIX_PORT_WIDE_SAMPLING is ignored when this is set to 1 since reading each input with one instruction 
+ * is already as fast as extracting it from a Port reading.
+ * 
+ * @note KB_NUMBER_OF_ROWS and KB_NUMBER_OF_COLUMNS must be written as plain decimal numbers (E.g. 4, not (4)) 
+ * when this is set to 1 since they select the unrolled expansion. See unroll.h.
+ * 
+ * @warning This can only be set to either 0 or 1, and KB_NUMBER_OF_ROWS and KB_NUMBER_OF_COLUMNS cannot exceed 
+ * 32 when this is set to 1. A compilation error will occur if this is not followed.
+ * 
+ */
+#define KB_MATRIX_UNROLLED_SCAN							1
 
 
 /**
@@ -140,11 +355,53 @@
 #define KB_DIODE_DIRECTION 								COL2ROW
 
 
+/**
+ * @brief Controls the Matrix Scanning Algorithm. Setting this to 1 strobes whichever of the Rows or Columns 
+ * has fewer pins so the least number of strobes are needed per scan. E.g. a 4x14 Keyboard strobes the 4 Rows 
+ * and samples the 14 Columns instead of strobing the 14 Columns. The strobe level is then derived from 
+ * KB_DIODE_DIRECTION since the strobed side must face the diode Cathode to be driven LOW, or the Anode to be 
+ * driven HIGH. Setting this to 0 uses KB_SET_COLUMNS_AS_INPUTS_OR_OUTPUTS, KB_SET_ROWS_AS_OUTPUTS, and 
+ * KB_KEYPRESS_DETECTION_LEVEL as-is.
+ * 
+ * @note When this is set to 1, KB_SET_COLUMNS_AS_INPUTS_OR_OUTPUTS, KB_SET_ROWS_AS_OUTPUTS, and 
+ * KB_KEYPRESS_DETECTION_LEVEL are ignored.
+ * 
+ * @warning If the derived strobe level is HIGH, the sampled side MUST have external pulldown resistors on 
+ * targets without internal pulldowns (such as ATMega16U4/ATMega32U4). A LOW strobe level uses the internal 
+ * pullups and needs no external resistors.
+ * 
+ * @warning This can only be set to either 0 or 1. A compilation error will occur if this is not followed.
+ * 
+ */
+#ifndef KB_MATRIX_AUTO_STROBE_ORIENTATION
+#define KB_MATRIX_AUTO_STROBE_ORIENTATION				1
+#endif
+
+
+/**
+ * @brief Setting this to 1 stops the Matrix Scanning Algorithm while no key is held. Every output is strobed at 
+ * once and the inputs are armed to interrupt on a pin change. The scan task registered with Matrix_Set_Task() is 
+ * made TASK_EVENT_DRIVEN, so the scheduler does not run it at all until a key is pressed. The wake interrupt makes 
+ * the task periodic again and due straight away, so the first press is not delayed by up to one scan period. 
+ * Setting this to 0 scans every period.
+ * 
+ * @note Only used if every sampled input can interrupt on a pin change. On ATMega16U4/ATMega32U4 these are 
+ * PB0 - PB7, PD0 - PD3 and PE6. Otherwise the Keyboard keeps scanning every period. The current COLUMN_PINS 
+ * are not all interrupt-capable, so this is left disabled.
+ * 
+ * @warning This can only be set to either 0 or 1. A compilation error will occur if this is not followed.
+ * 
+ */
+#ifndef KB_MATRIX_IDLE_WAKE_INTERRUPT
+#define KB_MATRIX_IDLE_WAKE_INTERRUPT					0
+#endif
+
 
 
 
-#define ROW_PINS					{BSP_PIN_PD0_INPUT_INTERNAL_PULLUP, BSP_PIN_PD1_INPUT_INTERNAL_PULLUP, BSP_PIN_PD2_INPUT_INTERNAL_PULLUP, BSP_PIN_PD3_INPUT_INTERNAL_PULLUP} // TODO: must all be set to one voltage state. i.e. all pulldown or all pullup. how can I do a compile check?
-#define COLUMN_PINS					{PIN_PF0, PIN_PF1, PIN_PF4, PIN_PF5, PIN_PF6, PIN_PF7, PIN_PC7, PIN_PC6, PIN_PB6, PIN_PB5, PIN_PB4, PIN_PD6, PIN_PD4, PIN_PD5} //TODO - add PD7 (LED) after testing
+
+#define ROW_PINS					{KB_PIN_PD0, KB_PIN_PD1, KB_PIN_PD2, KB_PIN_PD3}
+#define COLUMN_PINS					{KB_PIN_PF0, KB_PIN_PF1, KB_PIN_PF4, KB_PIN_PF5, KB_PIN_PF6, KB_PIN_PF7, KB_PIN_PC7, KB_PIN_PC6, KB_PIN_PB6, KB_PIN_PB5, KB_PIN_PB4, KB_PIN_PD6, KB_PIN_PD4, KB_PIN_PD5} //TODO - add PD7 (LED) after testing
 
 /* 
 	---------------------------------------------------------------------
@@ -161,7 +418,30 @@
 									 {KEY_CTRL,			KEY_GUI,	KEY_ALT,	KEY_NONE,	KEY_NONE,	KEY_NONE,	KEY_SPACE,	KEY_NONE,	KEY_NONE,	KEY_TILDE,	KEY_NONE,		KEY_DOWN,			KEY_NONE,		KEY_RIGHT}} //TODO - add back column 12 after done with debugging LED. Add layer 2
 
 /* Programmer declarations. Do not edit. */
-extern const Pinmap_t g_keyboard_rowpins[KB_NUMBER_OF_ROWS];
-extern const Pinmap_t g_keyboard_colpins[KB_NUMBER_OF_COLUMNS];
+extern const KB_PINSIZE_T g_keyboard_rowpins[KB_NUMBER_OF_ROWS];
+extern const KB_PINSIZE_T g_keyboard_colpins[KB_NUMBER_OF_COLUMNS];
+
+/**
+ * Strobe orientation and strobe level used by the Matrix Scanning Algorithm. KB_MATRIX_STROBE_ROWS is 1 
+ * if the Rows are strobed and the Columns are sampled, 0 if the Columns are strobed and the Rows are sampled.
+ * KB_MATRIX_STROBE_LEVEL is the level a strobed output is driven to, which is also the level a sampled input 
+ * reads when a key is pressed. See KB_MATRIX_AUTO_STROBE_ORIENTATION.
+ */
+#if (KB_MATRIX_AUTO_STROBE_ORIENTATION == 1)
+	#if (KB_NUMBER_OF_ROWS <= KB_NUMBER_OF_COLUMNS)
+		#define KB_MATRIX_STROBE_ROWS					1
+	#else
+		#define KB_MATRIX_STROBE_ROWS					0
+	#endif
+
+	#if ((KB_MATRIX_STROBE_ROWS == 1) == (KB_DIODE_DIRECTION == COL2ROW))
+		#define KB_MATRIX_STROBE_LEVEL					KB_PIN_LOW		/* Strobed side faces the Cathode. */
+	#else
+		#define KB_MATRIX_STROBE_LEVEL					KB_PIN_HIGH		/* Strobed side faces the Anode. */
+	#endif
+#else
+	#define KB_MATRIX_STROBE_ROWS						KB_SET_ROWS_AS_OUTPUTS
+	#define KB_MATRIX_STROBE_LEVEL						KB_KEYPRESS_DETECTION_LEVEL
+#endif
 
 #endif /* KEYBOARDCONFIG_H */
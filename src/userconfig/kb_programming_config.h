@@ -28,7 +28,9 @@
  * @warning A compilation error will occur if this is not set to 0 or 1.
  * 
  */
+#ifndef KB_ENABLE_JTAG
 #define KB_ENABLE_JTAG                          1
+#endif
 
 
 /**
@@ -61,7 +63,4 @@
 #define KB_ENABLE_PDI                           0
 
 
-#error "TODO: ADD THESE TO COMPILECHECKS.H"
-
-
 #endif /* KB_PROGRAMMING_CONFIG_H_ */
@@ -0,0 +1,577 @@
+/**
+ * @file host_bench.c
+ * @author Ian Ress
+ * @brief Microbenchmarks of the Application's hot paths on the host simulation. See host_bench.h.
+ * 
+ * The Keyboard PCB is modelled by host_pcb.h. The Hsm benchmarks use an Hsm with the same State hierarchy as 
+ * the USB HID Device Hsm, whose Entry and Exit Events do nothing, so only the Dispatcher is timed.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <avr/interrupt.h>
+#include "circular_buffer.h"
+#include "debounce.h"
+#include "hsm.h"
+#include "host_bench.h"
+#include "host_io.h"
+#include "host_pcb.h"
+#include "host_systick.h"
+#include "kb_config.h"
+#include "key_event.h"
+#include "keyboard_report.h"
+#include "matrix.h"
+#include "scheduler.h"
+
+static matrix_word_t bench_raw[MATRIX_NUMBER_OF_STROBES];
+static matrix_word_t bench_debounced[MATRIX_NUMBER_OF_STROBES];
+
+CIRCBUF_DEFINE(static, bench_circbuf, uint8_t, 32);
+
+
+/* Event Signals of the benchmarked Hsm. */
+enum
+{
+    BENCH_HSM_HANDLED_SIG = USER_SIG,           /* Handled by the current state. */
+    BENCH_HSM_IGNORED_SIG,                      /* Passed up to the Top State and ignored there. */
+    BENCH_HSM_TOGGLE_SIG                        /* Transition between the Address and Configured States. */
+};
+
+static HsmStatus bench_hsm_top_hndlr(Hsm * const me, const Event * const e);
+static HsmStatus bench_hsm_usb_hndlr(Hsm * const me, const Event * const e);
+static HsmStatus bench_hsm_address_hndlr(Hsm * const me, const Event * const e);
+static HsmStatus bench_hsm_configured_hndlr(Hsm * const me, const Event * const e);
+
+static const HsmState bench_hsm_top = {(HsmState *)0, bench_hsm_top_hndlr};
+static const HsmState bench_hsm_usb = {(HsmState *)&bench_hsm_top, bench_hsm_usb_hndlr};
+static const HsmState bench_hsm_address = {(HsmState *)&bench_hsm_usb, bench_hsm_address_hndlr};
+static const HsmState bench_hsm_configured = {(HsmState *)&bench_hsm_usb, bench_hsm_configured_hndlr};
+
+static const HsmState * const bench_hsm_address_path[] = {&bench_hsm_address, (HsmState *)0};
+static const HsmState * const bench_hsm_configured_path[] = {&bench_hsm_configured, (HsmState *)0};
+
+static const HsmTranPath bench_hsm_tran_paths[] =
+{
+    {&bench_hsm_address,    &bench_hsm_configured,  bench_hsm_address_path,     bench_hsm_configured_path},
+    {&bench_hsm_configured, &bench_hsm_address,     bench_hsm_configured_path,  bench_hsm_address_path},
+    {(HsmState *)0}
+};
+
+static Hsm bench_hsm;
+static const Event bench_hsm_handled = {BENCH_HSM_HANDLED_SIG};
+static const Event bench_hsm_ignored = {BENCH_HSM_IGNORED_SIG};
+static const Event bench_hsm_toggle = {BENCH_HSM_TOGGLE_SIG};
+
+static uint64_t bench_press_us;                 /* Simulated time of the press being measured. */
+static bool bench_press_reported;               /* True once a report with the press is written to the endpoint. */
+static bool bench_release_reported;             /* True once a report with the release is written to the endpoint. */
+static uint8_t bench_endpoint_bank[sizeof(Keyboard_Report_t)];  /* The IN endpoint's single bank of DPRAM. */
+static bool bench_endpoint_full;                /* FIFOCON handed the bank to the controller and the host has not taken it. */
+static Keyboard_Report_t bench_prev_report;     /* Last report written to the bank. */
+static uint8_t bench_usb_frames;                /* Frames since the host last polled the IN endpoint. */
+static uint32_t bench_rng = 0x2545F491U;
+
+
+/* State Handlers of the benchmarked Hsm. */
+static HsmStatus bench_hsm_top_hndlr(Hsm * const me, const Event * const e)
+{
+    (void)me;
+    (void)e;
+    return HSM_IGNORED_STATUS;
+}
+
+static HsmStatus bench_hsm_usb_hndlr(Hsm * const me, const Event * const e)
+{
+    if ((e->sig == ENTRY_EVENT) || (e->sig == EXIT_EVENT))
+    {
+        return HSM_HANDLED_STATUS;
+    }
+    return HSM_SUPER(bench_hsm_top);
+}
+
+static HsmStatus bench_hsm_address_hndlr(Hsm * const me, const Event * const e)
+{
+    if ((e->sig == ENTRY_EVENT) || (e->sig == EXIT_EVENT) || (e->sig == BENCH_HSM_HANDLED_SIG))
+    {
+        return HSM_HANDLED_STATUS;
+    }
+    else if (e->sig == BENCH_HSM_TOGGLE_SIG)
+    {
+        return HSM_TRAN(bench_hsm_configured);
+    }
+    return HSM_SUPER(bench_hsm_usb);
+}
+
+static HsmStatus bench_hsm_configured_hndlr(Hsm * const me, const Event * const e)
+{
+    if ((e->sig == ENTRY_EVENT) || (e->sig == EXIT_EVENT) || (e->sig == BENCH_HSM_HANDLED_SIG))
+    {
+        return HSM_HANDLED_STATUS;
+    }
+    else if (e->sig == BENCH_HSM_TOGGLE_SIG)
+    {
+        return HSM_TRAN(bench_hsm_address);
+    }
+    return HSM_SUPER(bench_hsm_usb);
+}
+
+
+/**
+ * @brief Constructs the benchmarked Hsm in the Address State. The Entry Events are not run.
+ * 
+ * @param paths Precomputed transition paths. NULL to determine every path at run-time.
+ * 
+ */
+static void bench_hsm_init(const HsmTranPath * const paths);
+static void bench_hsm_init(const HsmTranPath * const paths)
+{
+    Hsm_Ctor(&bench_hsm, bench_hsm_top_hndlr);
+    Hsm_Set_Tran_Paths(&bench_hsm, paths);
+    bench_hsm.state = (HsmState *)&bench_hsm_address;
+}
+
+
+/**
+ * @brief Repeatable pseudo-random numbers (xorshift32) for press phases and key positions.
+ * 
+ * @return Number between 0 and @p range - 1.
+ * 
+ */
+static uint32_t bench_random(uint32_t range);
+static uint32_t bench_random(uint32_t range)
+{
+    bench_rng ^= bench_rng << 13;
+    bench_rng ^= bench_rng >> 17;
+    bench_rng ^= bench_rng << 5;
+    return bench_rng % range;
+}
+
+
+/**
+ * @brief Simulated USB task of the keyboard's HID interface, following LUFA's HID_Device_USBTask(). Nothing is 
+ * built while the IN endpoint's bank is still full (TXINI clear), so key events stay queued until the host polls. 
+ * Otherwise the report is built with Keyboard_Report_Build() and, if it differs from the last one, written to 
+ * the bank byte by byte as it would be through UEDATX before FIFOCON is cleared. Marks when the measured press 
+ * and release reach the endpoint.
+ * 
+ */
+static void bench_usb_task(void);
+static void bench_usb_task(void)
+{
+    Keyboard_Report_t report;
+    const uint8_t * const bytes = (const uint8_t *)&report;
+
+    if (bench_endpoint_full)
+    {
+        return;
+    }
+
+    Keyboard_Report_Build(&report);
+
+    if (memcmp(&report, &bench_prev_report, sizeof(report)) == 0)
+    {
+        return;
+    }
+    bench_prev_report = report;
+
+    for (uint8_t i = 0; i < sizeof(report); i++)
+    {
+        bench_endpoint_bank[i] = bytes[i];
+    }
+    bench_endpoint_full = true;
+
+    if (report.keycodes[0] != KEY_NONE)
+    {
+        bench_press_reported = true;
+    }
+    else
+    {
+        bench_release_reported = true;
+    }
+}
+
+
+/**
+ * @brief Simulated USB host. Runs every 1ms frame from the systick hook and takes the report out of the IN 
+ * endpoint's bank every HOST_BENCH_USB_POLL_MS frames, which frees the bank for the next one.
+ * 
+ */
+static void bench_usb_host_frame(void);
+static void bench_usb_host_frame(void)
+{
+    if (++bench_usb_frames >= HOST_BENCH_USB_POLL_MS)
+    {
+        bench_usb_frames = 0;
+        bench_endpoint_full = false;
+    }
+}
+
+
+/**
+ * @brief Runs the scheduler and advances simulated time until @p done is true or @p timeout_us passes.
+ * 
+ * @return True if @p done became true.
+ * 
+ */
+static bool bench_run_until(const bool * const done, uint32_t timeout_us);
+static bool bench_run_until(const bool * const done, uint32_t timeout_us)
+{
+    for (uint32_t elapsed = 0; elapsed < timeout_us; elapsed += HOST_BENCH_LOOP_US)
+    {
+        Begin_Scheduler();
+
+        if (*done)
+        {
+            return true;
+        }
+
+        Host_Systick_Advance_Us(HOST_BENCH_LOOP_US);
+    }
+    return false;
+}
+
+
+/**
+ * @brief Inserts @p value into the sorted array @p sorted. stdlib.h's qsort() is not used because the host 
+ * include path shadows the system's endian.h with src/drivers/common/endian.h.
+ * 
+ * @param sorted Array sorted in ascending order with room for one more element.
+ * @param count Number of elements already in @p sorted.
+ * @param value Value to insert.
+ * 
+ */
+static void bench_insert_sorted(uint32_t * const sorted, uint32_t count, uint32_t value);
+static void bench_insert_sorted(uint32_t * const sorted, uint32_t count, uint32_t value)
+{
+    while ((count > 0U) && (sorted[count - 1U] > value))
+    {
+        sorted[count] = sorted[count - 1U];
+        count--;
+    }
+    sorted[count] = value;
+}
+
+
+/**
+ * @brief Returns the host's monotonic clock.
+ * 
+ * @return Nanoseconds since an arbitrary point.
+ * 
+ */
+static uint64_t bench_now_ns(void);
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+
+/* Benchmarked operations. */
+static void bench_matrix_scan(void)
+{
+    Matrix_Scan();
+}
+
+static void bench_debounce_bouncing(void)
+{
+    /* Every key flips every call. Worst case for the slot-based algorithms. */
+    for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++)
+    {
+        bench_raw[o] = (matrix_word_t)~bench_raw[o];
+    }
+    Debounce_Matrix(bench_raw, bench_debounced);
+}
+
+static void bench_debounce_stable(void)
+{
+    Debounce_Matrix(bench_raw, bench_debounced);
+}
+
+static void bench_noop_task(void)
+{
+}
+
+static void bench_scheduler_full(void)
+{
+    Begin_Scheduler();
+}
+
+static void bench_circbuf_bulk_16(void)
+{
+    uint8_t data[16] = {0};
+    (void)circbuf_write_bulk(&bench_circbuf, data, sizeof(data));
+    (void)circbuf_read_bulk(&bench_circbuf, data, sizeof(data));
+}
+
+static void bench_circbuf_write_read(void)
+{
+    uint8_t data = 0x5AU;
+    (void)circbuf_write(&bench_circbuf, &data);
+    (void)circbuf_read(&bench_circbuf, &data);
+}
+
+
+static void bench_hsm_dispatch_handled(void)
+{
+    Hsm_Dispatch(&bench_hsm, &bench_hsm_handled);
+}
+
+static void bench_hsm_dispatch_ignored(void)
+{
+    Hsm_Dispatch(&bench_hsm, &bench_hsm_ignored);
+}
+
+static void bench_hsm_dispatch_tran(void)
+{
+    Hsm_Dispatch(&bench_hsm, &bench_hsm_toggle);
+}
+
+
+/**
+ * @brief Times @p op and prints one JSON result line.
+ * 
+ * @param out Where the result is printed.
+ * @param name Benchmark name printed in the result.
+ * @param op Operation to time. Called @p iterations times in total.
+ * @param iterations Number of calls to @p op. Rounded down to a multiple of HOST_BENCH_REPETITIONS.
+ * 
+ */
+void Host_Bench_Measure(FILE * const out, const char * const name, void (*op)(void), uint32_t iterations)
+{
+    const uint32_t per_rep = (iterations / HOST_BENCH_REPETITIONS) ? (iterations / HOST_BENCH_REPETITIONS) : 1U;
+    double total_ns = 0.0;
+    double min_ns = 0.0;
+
+    for (uint32_t rep = 0; rep < HOST_BENCH_REPETITIONS; rep++)
+    {
+        const uint64_t start = bench_now_ns();
+
+        for (uint32_t i = 0; i < per_rep; i++)
+        {
+            op();
+        }
+
+        const double rep_ns = (double)(bench_now_ns() - start) / (double)per_rep;
+        total_ns += rep_ns;
+
+        if ((rep == 0U) || (rep_ns < min_ns))
+        {
+            min_ns = rep_ns;
+        }
+    }
+
+    fprintf(out, "{\"bench\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%.1f,\"ns_per_op_min\":%.1f}\n",
+            name, (unsigned long)(per_rep * HOST_BENCH_REPETITIONS), total_ns / HOST_BENCH_REPETITIONS, min_ns);
+}
+
+
+/**
+ * @brief Prints a task's execution statistics as one JSON line, E.g.:
+ * 
+ * 
+ *      {"task":"matrix_scan","runs":4210,"runtime_min_us":0,"runtime_avg_us":1,"runtime_max_us":3,...}
+ * 
+ * 
+ * Runtimes are in simulated time, so only busy-waits such as _delay_us() count towards them.
+ * 
+ * @param out Where the statistics are printed.
+ * @param name Task name printed in the result.
+ * @param task The task.
+ * 
+ */
+void Host_Bench_Print_Task_Stats(FILE * const out, const char * const name, const Task_t * const task)
+{
+    Task_Stats_t stats;
+
+    if (!Get_Task_Stats(task, &stats))
+    {
+        return;
+    }
+
+    fprintf(out, "{\"task\":\"%s\",\"runs\":%lu,\"runtime_min_us\":%lu,\"runtime_avg_us\":%lu,"
+                 "\"runtime_max_us\":%lu,\"late_max_us\":%lu,\"deadline_misses\":%lu}\n",
+            name, (unsigned long)stats.runs, (unsigned long)stats.runtime_min_us,
+            (unsigned long)(stats.runs ? (stats.runtime_total_us / stats.runs) : 0U),
+            (unsigned long)stats.runtime_max_us, (unsigned long)stats.late_max_us,
+            (unsigned long)stats.deadline_misses);
+}
+
+
+/**
+ * @brief Runs every benchmark. Resets the simulation before each one so they are independent.
+ * 
+ * @param out Where the results are printed.
+ * @param iterations Number of calls to each benchmarked operation.
+ * 
+ */
+void Host_Bench_Run_All(FILE * const out, uint32_t iterations)
+{
+    /* Matrix_Scan() with no keys held. Includes the debounce and event queue stages. */
+    Host_IO_Reset();
+    Host_Systick_Reset();
+    Host_PCB_Install();
+    Matrix_Init();
+    Host_Bench_Measure(out, "matrix_scan_idle", bench_matrix_scan, iterations);
+
+    /* Debounce_Matrix() on its own. */
+    Host_IO_Reset();
+    Host_Systick_Reset();
+    Debounce_Init();
+    for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++)
+    {
+        bench_raw[o] = 0;
+        bench_debounced[o] = 0;
+    }
+    Host_Bench_Measure(out, "debounce_stable", bench_debounce_stable, iterations);
+    Host_Bench_Measure(out, "debounce_bouncing", bench_debounce_bouncing, iterations);
+
+    /* Begin_Scheduler() with every slot taken and every task due each pass. */
+    Host_IO_Reset();
+    Host_Systick_Reset();
+    Clear_Scheduler();
+    for (uint8_t i = 0; i < (uint8_t)MAX_TASKS; i++)
+    {
+        (void)Create_Task(bench_noop_task, 0);
+    }
+    Host_Bench_Measure(out, "scheduler_full_table", bench_scheduler_full, iterations);
+    Clear_Scheduler();
+
+    /* Begin_Scheduler() with every slot taken and nothing due. */
+    for (uint8_t i = 0; i < (uint8_t)MAX_TASKS; i++)
+    {
+        (void)Create_Task(bench_noop_task, 1000);
+    }
+    Host_Bench_Measure(out, "scheduler_nothing_due", bench_scheduler_full, iterations);
+    Clear_Scheduler();
+
+    /* circbuf_write() followed by circbuf_read(). */
+    Host_Bench_Measure(out, "circbuf_write_read", bench_circbuf_write_read, iterations);
+
+    /* circbuf_write_bulk() and circbuf_read_bulk() of 16 bytes. */
+    Host_Bench_Measure(out, "circbuf_bulk_16", bench_circbuf_bulk_16, iterations);
+
+    /* Hsm_Dispatch() of an event handled in the current state, and of one ignored in the Top State. */
+    bench_hsm_init((HsmTranPath *)0);
+    Host_Bench_Measure(out, "hsm_dispatch_handled", bench_hsm_dispatch_handled, iterations);
+    Host_Bench_Measure(out, "hsm_dispatch_ignored", bench_hsm_dispatch_ignored, iterations);
+
+    /* Hsm_Dispatch() of a transition between sibling states, with the path found at run-time and precomputed. */
+    Host_Bench_Measure(out, "hsm_dispatch_tran_runtime", bench_hsm_dispatch_tran, iterations);
+    bench_hsm_init(bench_hsm_tran_paths);
+    Host_Bench_Measure(out, "hsm_dispatch_tran_table", bench_hsm_dispatch_tran, iterations);
+}
+
+
+/**
+ * @brief Measures keypress to HID report latency in simulated time with the given debounce and scan rate settings. 
+ * The Application runs under the real scheduler with Matrix_Scan() backing off between the given scan periods, a 
+ * simulated USB task every HOST_BENCH_USB_TASK_MS and a simulated host polling the IN endpoint every 
+ * HOST_BENCH_USB_POLL_MS. Each press is a random key pressed at a random phase relative to all of them, after a 
+ * random idle gap so the scan rate has also backed off by a random amount. Latency is measured from the press until 
+ * Keyboard_Report_Build() has put it in a report and the report has been written to the endpoint FIFO, ready for 
+ * the host's next poll.
+ * 
+ * Prints one JSON line with the configuration and the p50, p99 and max latency in microseconds, E.g.:
+ * 
+ * 
+ *      {"bench":"press_to_report_latency","measured_to":"endpoint_fifo","debounce_algorithm":0,...,"p50_us":5574,...}
+ * 
+ * 
+ * @param out Where the result is printed.
+ * @param presses Number of presses measured. At most HOST_BENCH_LATENCY_MAX_SAMPLES.
+ * @param config Debounce and scan rate settings. See Debounce_Configure() and Matrix_Configure_Scan_Rate().
+ * 
+ */
+void Host_Bench_Latency(FILE * const out, uint32_t presses, const Host_Bench_Latency_Config_t * const config)
+{
+    static uint32_t latencies[HOST_BENCH_LATENCY_MAX_SAMPLES];
+    const uint32_t window_ms = (config->debounce_press_ms > config->debounce_release_ms) ? 
+                               config->debounce_press_ms : config->debounce_release_ms;
+    const uint32_t timeout_us = (window_ms + config->scan_period_max_ms + 1000U) * 1000U;
+    uint32_t samples = 0;
+
+    if (presses > HOST_BENCH_LATENCY_MAX_SAMPLES)
+    {
+        presses = HOST_BENCH_LATENCY_MAX_SAMPLES;
+    }
+
+    Host_IO_Reset();
+    Host_Systick_Reset();
+    Clear_Scheduler();
+    Key_Event_Init();
+    Keyboard_Report_Init();
+    Host_PCB_Install();
+    Systick_Init();
+    Matrix_Init();
+    Debounce_Configure(config->debounce_algorithm, config->debounce_press_ms, config->debounce_release_ms);
+    Task_t * const scan_task = Create_Task(Matrix_Scan, config->scan_period_min_ms);
+    Task_t * const usb_task = Create_Task(bench_usb_task, HOST_BENCH_USB_TASK_MS);
+    Matrix_Set_Task(scan_task);
+    Matrix_Configure_Scan_Rate(config->scan_period_min_ms, config->scan_period_max_ms, config->scan_backoff_ms);
+
+    memset(&bench_prev_report, 0, sizeof(bench_prev_report));
+    bench_endpoint_full = false;
+    bench_usb_frames = 0;
+    Host_Systick_Set_Hook(bench_usb_host_frame);
+    Systick_Start();
+    sei();
+
+    for (uint32_t i = 0; i < presses; i++)
+    {
+        const uint8_t row = (uint8_t)bench_random(KB_NUMBER_OF_ROWS);
+        const uint8_t column = (uint8_t)bench_random(KB_NUMBER_OF_COLUMNS);
+
+        /* Idle for a random time, then press at a random sub-millisecond phase. */
+        const bool never = false;
+        (void)bench_run_until(&never, HOST_BENCH_LOOP_US * bench_random((HOST_BENCH_MAX_IDLE_MS * 1000U) / HOST_BENCH_LOOP_US));
+        Host_Systick_Advance_Us(bench_random(HOST_BENCH_LOOP_US));
+
+        bench_press_reported = false;
+        bench_release_reported = false;
+        bench_press_us = Host_Systick_Now_Us();
+        Host_PCB_Set_Key(row, column, true);
+
+        if (bench_run_until(&bench_press_reported, timeout_us))
+        {
+            bench_insert_sorted(latencies, samples, (uint32_t)(Host_Systick_Now_Us() - bench_press_us));
+            samples++;
+        }
+
+        Host_PCB_Set_Key(row, column, false);
+        (void)bench_run_until(&bench_release_reported, timeout_us);
+    }
+
+    cli();
+    Systick_Stop();
+    Host_Systick_Set_Hook(NULL);
+    Host_Bench_Print_Task_Stats(out, "matrix_scan", scan_task);
+    Host_Bench_Print_Task_Stats(out, "usb_task", usb_task);
+    Clear_Scheduler();
+
+    fprintf(out, "{\"bench\":\"press_to_report_latency\",\"measured_to\":\"endpoint_fifo\","
+                 "\"debounce_algorithm\":%u,\"debounce_press_ms\":%u,\"debounce_release_ms\":%u,"
+                 "\"scan_period_min_ms\":%u,\"scan_period_max_ms\":%u,\"scan_backoff_ms\":%u,"
+                 "\"usb_task_ms\":%u,\"usb_poll_ms\":%u,\"samples\":%lu",
+            config->debounce_algorithm, config->debounce_press_ms, config->debounce_release_ms,
+            config->scan_period_min_ms, config->scan_period_max_ms, config->scan_backoff_ms,
+            HOST_BENCH_USB_TASK_MS, HOST_BENCH_USB_POLL_MS, (unsigned long)samples);
+
+    if (samples == 0U)
+    {
+        fprintf(out, "}\n");
+        return;
+    }
+
+    fprintf(out, ",\"p50_us\":%lu,\"p99_us\":%lu,\"max_us\":%lu}\n",
+            (unsigned long)latencies[((samples - 1U) * 50U) / 100U],
+            (unsigned long)latencies[((samples - 1U) * 99U) / 100U],
+            (unsigned long)latencies[samples - 1U]);
+}
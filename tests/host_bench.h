@@ -0,0 +1,87 @@
+/**
+ * @file host_bench.h
+ * @author Ian Ress
+ * @brief Microbenchmarks of the Application's hot paths on the host simulation. Each benchmark times an 
+ * entry point with the host's monotonic clock and prints one JSON object per line so results can be 
+ * collected and compared per commit, E.g.:
+ * 
+ * 
+ *      {"bench":"matrix_scan_idle","iterations":100000,"ns_per_op":812.4,"ns_per_op_min":790.1}
+ * 
+ * 
+ * ns_per_op is the mean over every repetition and ns_per_op_min is the fastest repetition, which is the 
+ * less noisy of the two on a shared machine. Host timings rank changes against each other. They are not 
+ * AVR cycle counts.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "scheduler.h"
+#include "systick.h"
+
+/**
+ * @brief Number of timed repetitions of each benchmark. The iterations are split evenly between them.
+ * 
+ */
+#define HOST_BENCH_REPETITIONS                  10U
+
+/**
+ * @brief Simulated USB polling interval of the keyboard's IN endpoint in ms. 1ms is the fastest Full Speed 
+ * interrupt endpoint.
+ * 
+ */
+#define HOST_BENCH_USB_POLL_MS                  1U
+
+/**
+ * @brief Period of the simulated USB task that builds the HID report and writes it to the IN endpoint in ms.
+ * 
+ */
+#define HOST_BENCH_USB_TASK_MS                  1U
+
+/**
+ * @brief Simulated time of one main loop pass in us, which is the resolution of the latency measurement.
+ * 
+ */
+#define HOST_BENCH_LOOP_US                      50U
+
+/**
+ * @brief Longest random idle time between measured presses in ms.
+ * 
+ */
+#define HOST_BENCH_MAX_IDLE_MS                  200U
+
+/**
+ * @brief Maximum number of presses measured by Host_Bench_Latency().
+ * 
+ */
+#define HOST_BENCH_LATENCY_MAX_SAMPLES          1000U
+
+/**
+ * @brief Settings measured by Host_Bench_Latency(). The debounce settings are passed to Debounce_Configure() and 
+ * the scan rate settings to Matrix_Configure_Scan_Rate().
+ * 
+ */
+typedef struct
+{
+    uint8_t debounce_algorithm;                 /* The KB_DEBOUNCE_xxx value. */
+    systick_wordsize_t debounce_press_ms;
+    systick_wordsize_t debounce_release_ms;
+    systick_wordsize_t scan_period_min_ms;
+    systick_wordsize_t scan_period_max_ms;
+    systick_wordsize_t scan_backoff_ms;
+} Host_Bench_Latency_Config_t;
+
+void Host_Bench_Measure(FILE * const out, const char * const name, void (*op)(void), uint32_t iterations);
+void Host_Bench_Run_All(FILE * const out, uint32_t iterations);
+void Host_Bench_Latency(FILE * const out, uint32_t presses, const Host_Bench_Latency_Config_t * const config);
+void Host_Bench_Print_Task_Stats(FILE * const out, const char * const name, const Task_t * const task);
+
+#endif /* HOST_BENCH_H */
@@ -0,0 +1,124 @@
+/**
+ * @file host_bench_main.c
+ * @author Ian Ress
+ * @brief Runs every host benchmark and prints the JSON results to stdout. See host_bench.h. Usage:
+ * 
+ * 
+ *      host_bench [iterations] [presses] [algorithm press_ms release_ms [scan_min_ms scan_max_ms backoff_ms]]
+ * 
+ * 
+ * iterations is the number of calls to each benchmarked operation (default 100000). presses is the number 
+ * of presses measured by the latency benchmark (default 200). The latency benchmark runs once per debounce 
+ * algorithm with the windows in kb_config.h, or once with the given algorithm (The KB_DEBOUNCE_xxx value) 
+ * and windows in ms. E.g. host_bench 100000 200 3 2 5 measures KB_DEBOUNCE_ASYMMETRIC with a 2ms press window 
+ * and a 5ms release window. Each of those runs once per scan rate in bench_scan_rates[], or once with the 
+ * given scan periods and back-off time in ms. E.g. host_bench 100000 200 0 5 5 2 2 100 scans every 2ms.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "host_bench.h"
+#include "kb_config.h"
+
+#define HOST_BENCH_DEFAULT_ITERATIONS           100000UL
+#define HOST_BENCH_DEFAULT_PRESSES              200UL
+
+/**
+ * @brief Scan rates swept by the latency benchmark: the adaptive rate in kb_config.h, and fixed rates at its 
+ * minimum and maximum period. Only the scan rate fields are used.
+ * 
+ */
+static const Host_Bench_Latency_Config_t bench_scan_rates[] =
+{
+    {0, 0, 0, KB_MATRIX_SCAN_PERIOD_MIN_MS, KB_MATRIX_SCAN_PERIOD_MAX_MS, KB_MATRIX_SCAN_BACKOFF_MS},
+    {0, 0, 0, KB_MATRIX_SCAN_PERIOD_MIN_MS, KB_MATRIX_SCAN_PERIOD_MIN_MS, KB_MATRIX_SCAN_BACKOFF_MS},
+    {0, 0, 0, KB_MATRIX_SCAN_PERIOD_MAX_MS, KB_MATRIX_SCAN_PERIOD_MAX_MS, KB_MATRIX_SCAN_BACKOFF_MS}
+};
+
+
+/**
+ * @brief Reads an optional numeric argument. stdlib.h's strtoul() is not used for the same reason as 
+ * qsort() in host_bench.c.
+ * 
+ * @return The argument, or @p fallback if it is missing or not a number.
+ * 
+ */
+static uint32_t bench_arg(int argc, char ** argv, int index, uint32_t fallback);
+static uint32_t bench_arg(int argc, char ** argv, int index, uint32_t fallback)
+{
+    unsigned long value;
+
+    if ((index < argc) && (sscanf(argv[index], "%lu", &value) == 1))
+    {
+        return (uint32_t)value;
+    }
+    return fallback;
+}
+
+
+/**
+ * @brief Runs the latency benchmark with @p config's debounce settings, once per scan rate in bench_scan_rates[] 
+ * or once with the scan rate given on the command line.
+ * 
+ */
+static void bench_latency(int argc, char ** argv, uint32_t presses, Host_Bench_Latency_Config_t config);
+static void bench_latency(int argc, char ** argv, uint32_t presses, Host_Bench_Latency_Config_t config)
+{
+    if (argc > 8)
+    {
+        config.scan_period_min_ms = (systick_wordsize_t)bench_arg(argc, argv, 6, KB_MATRIX_SCAN_PERIOD_MIN_MS);
+        config.scan_period_max_ms = (systick_wordsize_t)bench_arg(argc, argv, 7, KB_MATRIX_SCAN_PERIOD_MAX_MS);
+        config.scan_backoff_ms = (systick_wordsize_t)bench_arg(argc, argv, 8, KB_MATRIX_SCAN_BACKOFF_MS);
+        Host_Bench_Latency(stdout, presses, &config);
+        return;
+    }
+
+    for (uint8_t i = 0; i < (uint8_t)(sizeof(bench_scan_rates) / sizeof(bench_scan_rates[0])); i++)
+    {
+        config.scan_period_min_ms = bench_scan_rates[i].scan_period_min_ms;
+        config.scan_period_max_ms = bench_scan_rates[i].scan_period_max_ms;
+        config.scan_backoff_ms = bench_scan_rates[i].scan_backoff_ms;
+        Host_Bench_Latency(stdout, presses, &config);
+    }
+}
+
+
+int main(int argc, char ** argv)
+{
+    const uint32_t presses = bench_arg(argc, argv, 2, HOST_BENCH_DEFAULT_PRESSES);
+
+    Host_Bench_Run_All(stdout, bench_arg(argc, argv, 1, HOST_BENCH_DEFAULT_ITERATIONS));
+
+    if (argc > 5)
+    {
+        const Host_Bench_Latency_Config_t config =
+        {
+            (uint8_t)bench_arg(argc, argv, 3, KB_DEBOUNCE_DEFERRED),
+            (systick_wordsize_t)bench_arg(argc, argv, 4, KB_DEBOUNCE_TIME_MS),
+            (systick_wordsize_t)bench_arg(argc, argv, 5, KB_DEBOUNCE_TIME_MS),
+            0, 0, 0
+        };
+        bench_latency(argc, argv, presses, config);
+    }
+    else
+    {
+        const Host_Bench_Latency_Config_t configs[] =
+        {
+            {KB_DEBOUNCE_DEFERRED, KB_DEBOUNCE_TIME_MS, KB_DEBOUNCE_TIME_MS, 0, 0, 0},
+            {KB_DEBOUNCE_EAGER, KB_DEBOUNCE_TIME_MS, KB_DEBOUNCE_TIME_MS, 0, 0, 0},
+            {KB_DEBOUNCE_ASYMMETRIC, KB_DEBOUNCE_PRESS_TIME_MS, KB_DEBOUNCE_RELEASE_TIME_MS, 0, 0, 0},
+            {KB_DEBOUNCE_VERTICAL_COUNTER, KB_DEBOUNCE_TIME_MS, KB_DEBOUNCE_TIME_MS, 0, 0, 0}
+        };
+
+        for (uint8_t i = 0; i < (uint8_t)(sizeof(configs) / sizeof(configs[0])); i++)
+        {
+            bench_latency(argc, argv, presses, configs[i]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file host_pcb.c
+ * @author Ian Ress
+ * @brief Model of the Keyboard PCB for the host simulation. See host_pcb.h.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include "bsp_gpio.h"
+#include "host_io.h"
+#include "host_pcb.h"
+#include "kb_config.h"
+
+static const KB_PINSIZE_T pcb_row_pins[KB_NUMBER_OF_ROWS] = ROW_PINS;
+static const KB_PINSIZE_T pcb_column_pins[KB_NUMBER_OF_COLUMNS] = COLUMN_PINS;
+
+static bool pcb_key_held = false;
+static KB_PINSIZE_T pcb_key_strobe;             /* Strobe pin of the held key. */
+static KB_PINSIZE_T pcb_key_sense;              /* Sense pin of the held key. */
+
+
+/**
+ * @brief Register hook modelling the Keyboard PCB. See file description.
+ * 
+ * @param address Register address about to be accessed.
+ * 
+ */
+static void pcb_hook(uint16_t address);
+static void pcb_hook(uint16_t address)
+{
+    if ((address >= 0x23U) && (address <= 0x2FU) && (((address - 0x20U) % 3U) == 0U)) /* PINB - PINF */
+    {
+        uint8_t pins = g_host_io_registers[address + 2U];
+
+        if (pcb_key_held && (BSP_GET_PORT(pcb_key_sense) == ((address - 0x20U) / 3U)))
+        {
+            const uint16_t strobe_ddr = 0x21U + (0x03U * BSP_GET_PORT(pcb_key_strobe));
+            const uint8_t strobe_bit = (uint8_t)(1U << BSP_GET_PIN(pcb_key_strobe));
+            const bool driven = (g_host_io_registers[strobe_ddr] & strobe_bit) != 0;
+            const bool level = (g_host_io_registers[strobe_ddr + 1U] & strobe_bit) != 0;
+
+            if (driven && (level == (KB_MATRIX_STROBE_LEVEL == KB_PIN_HIGH)))
+            {
+                const uint8_t sense_bit = (uint8_t)(1U << BSP_GET_PIN(pcb_key_sense));
+                pins = level ? (uint8_t)(pins | sense_bit) : (uint8_t)(pins & ~sense_bit);
+            }
+        }
+
+        g_host_io_registers[address] = pins;
+    }
+}
+
+
+/**
+ * @brief Installs the PCB model as the register hook with no key held. Call after Host_IO_Reset(), which 
+ * removes the hook.
+ * 
+ */
+void Host_PCB_Install(void)
+{
+    pcb_key_held = false;
+    Host_IO_Set_Hook(pcb_hook);
+}
+
+
+/**
+ * @brief Holds down the key at @p row and @p column. Releases it if @p held is false.
+ * 
+ * @param row Index into ROW_PINS.
+ * @param column Index into COLUMN_PINS.
+ * @param held True to hold the key down.
+ * 
+ */
+void Host_PCB_Set_Key(uint8_t row, uint8_t column, bool held)
+{
+    #if (KB_MATRIX_STROBE_ROWS == 1)
+        pcb_key_strobe = pcb_row_pins[row];
+        pcb_key_sense = pcb_column_pins[column];
+    #else
+        pcb_key_strobe = pcb_column_pins[column];
+        pcb_key_sense = pcb_row_pins[row];
+    #endif
+    pcb_key_held = held;
+}
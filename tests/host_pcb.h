@@ -0,0 +1,24 @@
+/**
+ * @file host_pcb.h
+ * @author Ian Ress
+ * @brief Model of the Keyboard PCB for the host simulation. Installed as the register hook (See host_io.h) 
+ * so every PINx read is derived from the current PORTx/DDRx values and the key being held: the held key's 
+ * sense pin follows its strobe pin while the strobe pin is driven to KB_MATRIX_STROBE_LEVEL. Every other 
+ * input reads back its pull-up/PORTx value. One key can be held at a time.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef HOST_PCB_H
+#define HOST_PCB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void Host_PCB_Install(void);
+void Host_PCB_Set_Key(uint8_t row, uint8_t column, bool held);
+
+#endif /* HOST_PCB_H */
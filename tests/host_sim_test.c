@@ -0,0 +1,1102 @@
+/**
+ * @file host_sim_test.c
+ * @author Ian Ress
+ * @brief Checks the Application against the host simulation. Built by the host target in CMakeLists.txt and 
+ * run with ctest. Prints every failed check and returns non-zero if any check failed.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <util/delay.h>
+#include "host_io.h"
+#include "host_pcb.h"
+#include "host_systick.h"
+#include "hsm.h"
+#include "circular_buffer.h"
+#include "debounce.h"
+#include "kb_config.h"
+#include "key_event.h"
+#include "matrix.h"
+#include "scheduler.h"
+#include "systick.h"
+
+/**
+ * @brief Records a failed check without stopping the test so every failure is reported.
+ * 
+ */
+#define TEST_CHECK(condition)                                                               \
+    do                                                                                      \
+    {                                                                                       \
+        test_checks++;                                                                      \
+        if (!(condition))                                                                   \
+        {                                                                                   \
+            test_failures++;                                                                \
+            printf("%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #condition); \
+        }                                                                                   \
+    } while (0)
+
+static unsigned test_checks = 0;
+static unsigned test_failures = 0;
+static unsigned test_task_runs = 0;
+static char test_log[64];                       /* One character per task run, in the order they ran. */
+static uint8_t test_log_length = 0;
+static Task_t* test_signal_target = NULL;       /* Signalled by test_task_s(). */
+static systick_wordsize_t test_run_ms[16];      /* g_ms at each run of test_overrun_task(). */
+static matrix_word_t test_raw[MATRIX_NUMBER_OF_STROBES];
+static matrix_word_t test_debounced[MATRIX_NUMBER_OF_STROBES];
+CIRCBUF_DEFINE(static, test_circbuf, uint16_t, 8);
+
+
+/**
+ * @brief Resets the whole simulation. Every test starts from here.
+ * 
+ */
+static void test_reset(void);
+static void test_reset(void)
+{
+    Host_IO_Reset();
+    Host_Systick_Reset();
+    Clear_Scheduler();
+    Key_Event_Init();
+    Host_PCB_Install();
+    test_task_runs = 0;
+    test_log_length = 0;
+    test_log[0] = '\0';
+    test_signal_target = NULL;
+}
+
+
+/**
+ * @brief Scans the matrix once per simulated ms until a key event is queued or @p timeout_ms passes.
+ * 
+ * @return True if an event was popped into @p event.
+ * 
+ */
+static bool test_scan_until_event(Key_Event_t * const event, uint32_t timeout_ms);
+static bool test_scan_until_event(Key_Event_t * const event, uint32_t timeout_ms)
+{
+    for (uint32_t ms = 0; ms < timeout_ms; ms++)
+    {
+        Matrix_Scan();
+
+        if (Key_Event_Pop(event))
+        {
+            return true;
+        }
+
+        Host_Systick_Advance_Us(1000U);
+    }
+    return false;
+}
+
+
+static void test_counting_task(void);
+static void test_counting_task(void)
+{
+    test_task_runs++;
+}
+
+
+/**
+ * @brief Starts the systick and switches the debounce engine to @p algorithm with every key released.
+ * 
+ */
+static void test_debounce_reset(uint8_t algorithm, systick_wordsize_t press_time_ms, systick_wordsize_t release_time_ms);
+static void test_debounce_reset(uint8_t algorithm, systick_wordsize_t press_time_ms, systick_wordsize_t release_time_ms)
+{
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+    Debounce_Configure(algorithm, press_time_ms, release_time_ms);
+
+    for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++)
+    {
+        test_raw[o] = 0;
+        test_debounced[o] = 0;
+    }
+}
+
+
+/**
+ * @brief Sets the raw reading of key (0, 0) and debounces once per simulated ms, starting at the current time, 
+ * until its debounced state follows.
+ * 
+ * @return Milliseconds from the first scan until the scan that registered the change. UINT32_MAX if it did not 
+ * register within @p max_ms, in which case @p max_ms + 1 scans ran.
+ * 
+ */
+static uint32_t test_debounce_key(bool pressed, uint32_t max_ms);
+static uint32_t test_debounce_key(bool pressed, uint32_t max_ms)
+{
+    test_raw[0] = pressed ? (matrix_word_t)(test_raw[0] | 1U) : (matrix_word_t)(test_raw[0] & ~1U);
+
+    for (uint32_t ms = 0; ms <= max_ms; ms++)
+    {
+        Debounce_Matrix(test_raw, test_debounced);
+
+        if ((test_debounced[0] & 1U) == (test_raw[0] & 1U))
+        {
+            return ms;
+        }
+
+        Host_Systick_Advance_Us(1000U);
+    }
+    return UINT32_MAX;
+}
+
+
+/**
+ * @brief Runs the scheduler for @p us of simulated time, one pass every 50us. Time a task handler spends is 
+ * counted towards @p us.
+ * 
+ */
+static void test_run_scheduler(uint32_t us);
+static void test_run_scheduler(uint32_t us)
+{
+    const uint64_t end_us = Host_Systick_Now_Us() + us;
+
+    while (Host_Systick_Now_Us() < end_us)
+    {
+        Begin_Scheduler();
+        Host_Systick_Advance_Us(50U);
+    }
+}
+
+
+/**
+ * @brief Appends @p c to test_log.
+ * 
+ */
+static void test_log_append(char c);
+static void test_log_append(char c)
+{
+    if (test_log_length < (sizeof(test_log) - 1U))
+    {
+        test_log[test_log_length++] = c;
+        test_log[test_log_length] = '\0';
+    }
+}
+
+
+/**
+ * @brief Tasks that log their name when they run.
+ * 
+ */
+static void test_task_a(void);
+static void test_task_a(void)
+{
+    test_log_append('a');
+}
+
+
+static void test_task_b(void);
+static void test_task_b(void)
+{
+    test_log_append('b');
+}
+
+
+static void test_task_c(void);
+static void test_task_c(void)
+{
+    test_log_append('c');
+}
+
+
+/**
+ * @brief Logs its run and signals test_signal_target the first time, E.g. as a low priority task handing work 
+ * over to a high priority one.
+ * 
+ */
+static void test_task_s(void);
+static void test_task_s(void)
+{
+    test_log_append('s');
+
+    if (test_signal_target != NULL)
+    {
+        Signal_Task(test_signal_target);
+        test_signal_target = NULL;
+    }
+}
+
+
+/**
+ * @brief Records g_ms at every run. The first run overruns by 35ms.
+ * 
+ */
+static void test_overrun_task(void);
+static void test_overrun_task(void)
+{
+    if (test_task_runs < (sizeof(test_run_ms) / sizeof(test_run_ms[0])))
+    {
+        test_run_ms[test_task_runs] = Systick_Get_Ms();
+    }
+
+    if (test_task_runs++ == 0U)
+    {
+        Host_Systick_Advance_Us(35000U);
+    }
+}
+
+
+/* Event Signals of the test Hsm. Each is handled by one state and makes one transition. */
+enum
+{
+    TEST_HSM_A11_TO_B1_SIG = USER_SIG,          /* HSM_TRAN(B1) in A11. */
+    TEST_HSM_A11_TO_A1_SIG,                     /* HSM_TRAN(A1) in A11. */
+    TEST_HSM_A_TO_A11_SIG,                      /* HSM_TRAN(A11) in A. */
+    TEST_HSM_A_INTERNAL_A1_SIG,                 /* HSM_INTERNAL_TRAN(A1) in A. */
+    TEST_HSM_B1_TO_A11_SIG                      /* HSM_TRAN(A11) in B1. */
+};
+
+/**
+ * @brief Test Hsm. A1 is nested in A and A11 in A1. B1 is nested in B. A and B are nested in the Top State.
+ * 
+ */
+static HsmStatus test_hsm_top_hndlr(Hsm * const me, const Event * const e);
+static HsmStatus test_hsm_a_hndlr(Hsm * const me, const Event * const e);
+static HsmStatus test_hsm_a1_hndlr(Hsm * const me, const Event * const e);
+static HsmStatus test_hsm_a11_hndlr(Hsm * const me, const Event * const e);
+static HsmStatus test_hsm_b_hndlr(Hsm * const me, const Event * const e);
+static HsmStatus test_hsm_b1_hndlr(Hsm * const me, const Event * const e);
+
+static const HsmState test_hsm_top = {(HsmState *)0, test_hsm_top_hndlr};
+static const HsmState test_hsm_a = {(HsmState *)&test_hsm_top, test_hsm_a_hndlr};
+static const HsmState test_hsm_a1 = {(HsmState *)&test_hsm_a, test_hsm_a1_hndlr};
+static const HsmState test_hsm_a11 = {(HsmState *)&test_hsm_a1, test_hsm_a11_hndlr};
+static const HsmState test_hsm_b = {(HsmState *)&test_hsm_top, test_hsm_b_hndlr};
+static const HsmState test_hsm_b1 = {(HsmState *)&test_hsm_b, test_hsm_b1_hndlr};
+
+/* The same transitions worked out by hand, as an application would declare them. */
+static const HsmState * const test_hsm_none_path[] = {(HsmState *)0};
+static const HsmState * const test_hsm_a_path[] = {&test_hsm_a, (HsmState *)0};
+static const HsmState * const test_hsm_a1_path[] = {&test_hsm_a1, (HsmState *)0};
+static const HsmState * const test_hsm_a11_a1_path[] = {&test_hsm_a11, &test_hsm_a1, (HsmState *)0};
+static const HsmState * const test_hsm_a11_a1_a_path[] = {&test_hsm_a11, &test_hsm_a1, &test_hsm_a, (HsmState *)0};
+static const HsmState * const test_hsm_a_a1_a11_path[] = {&test_hsm_a, &test_hsm_a1, &test_hsm_a11, (HsmState *)0};
+static const HsmState * const test_hsm_b_b1_path[] = {&test_hsm_b, &test_hsm_b1, (HsmState *)0};
+static const HsmState * const test_hsm_b1_b_path[] = {&test_hsm_b1, &test_hsm_b, (HsmState *)0};
+
+static const HsmTranPath test_hsm_tran_paths[] =
+{
+    {&test_hsm_a11, &test_hsm_b1,   test_hsm_a11_a1_a_path, test_hsm_b_b1_path},
+    {&test_hsm_a11, &test_hsm_a1,   test_hsm_a11_a1_path,   test_hsm_a1_path},
+    {&test_hsm_a,   &test_hsm_a11,  test_hsm_a_path,        test_hsm_a_a1_a11_path},
+    {&test_hsm_a,   &test_hsm_a1,   test_hsm_none_path,     test_hsm_a1_path},
+    {&test_hsm_b1,  &test_hsm_a11,  test_hsm_b1_b_path,     test_hsm_a_a1_a11_path},
+    {(HsmState *)0}
+};
+
+static Hsm test_hsm;
+
+
+/**
+ * @brief Logs the Entry or Exit Event of state @p name, E.g. "A1+" or "A1-", separated by spaces.
+ * 
+ * @return True if @p e was an Entry or Exit Event.
+ * 
+ */
+static bool test_hsm_log(const char * name, const Event * const e);
+static bool test_hsm_log(const char * name, const Event * const e)
+{
+    if ((e->sig != ENTRY_EVENT) && (e->sig != EXIT_EVENT))
+    {
+        return false;
+    }
+
+    if (test_log_length != 0U)
+    {
+        test_log_append(' ');
+    }
+    while (*name)
+    {
+        test_log_append(*name++);
+    }
+    test_log_append((e->sig == ENTRY_EVENT) ? '+' : '-');
+    return true;
+}
+
+
+/* State Handlers of the test Hsm. */
+static HsmStatus test_hsm_top_hndlr(Hsm * const me, const Event * const e)
+{
+    (void)me;
+    (void)e;
+    return HSM_IGNORED_STATUS;
+}
+
+static HsmStatus test_hsm_a_hndlr(Hsm * const me, const Event * const e)
+{
+    if (test_hsm_log("A", e))
+    {
+        return HSM_HANDLED_STATUS;
+    }
+    else if (e->sig == TEST_HSM_A_TO_A11_SIG)
+    {
+        return HSM_TRAN(test_hsm_a11);
+    }
+    else if (e->sig == TEST_HSM_A_INTERNAL_A1_SIG)
+    {
+        return HSM_INTERNAL_TRAN(test_hsm_a1);
+    }
+    return HSM_SUPER(test_hsm_top);
+}
+
+static HsmStatus test_hsm_a1_hndlr(Hsm * const me, const Event * const e)
+{
+    if (test_hsm_log("A1", e))
+    {
+        return HSM_HANDLED_STATUS;
+    }
+    return HSM_SUPER(test_hsm_a);
+}
+
+static HsmStatus test_hsm_a11_hndlr(Hsm * const me, const Event * const e)
+{
+    if (test_hsm_log("A11", e))
+    {
+        return HSM_HANDLED_STATUS;
+    }
+    else if (e->sig == TEST_HSM_A11_TO_B1_SIG)
+    {
+        return HSM_TRAN(test_hsm_b1);
+    }
+    else if (e->sig == TEST_HSM_A11_TO_A1_SIG)
+    {
+        return HSM_TRAN(test_hsm_a1);
+    }
+    return HSM_SUPER(test_hsm_a1);
+}
+
+static HsmStatus test_hsm_b_hndlr(Hsm * const me, const Event * const e)
+{
+    if (test_hsm_log("B", e))
+    {
+        return HSM_HANDLED_STATUS;
+    }
+    return HSM_SUPER(test_hsm_top);
+}
+
+static HsmStatus test_hsm_b1_hndlr(Hsm * const me, const Event * const e)
+{
+    if (test_hsm_log("B1", e))
+    {
+        return HSM_HANDLED_STATUS;
+    }
+    else if (e->sig == TEST_HSM_B1_TO_A11_SIG)
+    {
+        return HSM_TRAN(test_hsm_a11);
+    }
+    return HSM_SUPER(test_hsm_b);
+}
+
+
+/**
+ * @brief Puts the test Hsm in @p state without running any Entry Events, clears test_log and dispatches @p sig.
+ * 
+ * @param paths Precomputed transition paths. NULL to determine every path at run-time.
+ * 
+ */
+static void test_hsm_dispatch(const HsmTranPath * const paths, const HsmState * const state, Signal sig);
+static void test_hsm_dispatch(const HsmTranPath * const paths, const HsmState * const state, Signal sig)
+{
+    const Event e = {sig};
+
+    Hsm_Ctor(&test_hsm, test_hsm_top_hndlr);
+    Hsm_Set_Tran_Paths(&test_hsm, paths);
+    test_hsm.state = (HsmState *)state;
+    test_log_length = 0;
+    test_log[0] = '\0';
+
+    Hsm_Dispatch(&test_hsm, &e);
+}
+
+
+#if (KB_MATRIX_IDLE_WAKE_INTERRUPT == 1)
+/**
+ * @brief The matrix wake interrupt, defined by BSP_GPIO_WAKE_ISR() in matrix.c. INT0 - INT3 alias it.
+ * 
+ */
+void PCINT0_vect(void);
+
+
+/**
+ * @brief Scan task that counts its runs.
+ * 
+ */
+static void test_scan_task(void);
+static void test_scan_task(void)
+{
+    test_task_runs++;
+    Matrix_Scan();
+}
+
+
+/**
+ * @brief A quiet matrix goes idle and its scan task stops running. A press raises the wake interrupt, which 
+ * signals the task so the next scheduler pass scans, and the task is periodic again until the matrix is quiet.
+ * 
+ */
+static void test_matrix_idle_wake(void);
+static void test_matrix_idle_wake(void)
+{
+    const uint32_t timeout_ms = (uint32_t)(KB_DEBOUNCE_TIME_MS) + (KB_MATRIX_SCAN_PERIOD_MAX_MS) + 10U;
+    Key_Event_t event;
+
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+    Matrix_Init();
+
+    Task_t* const task = Create_Task(test_scan_task, KB_MATRIX_SCAN_PERIOD_MIN_MS);
+    TEST_CHECK(task != NULL);
+    Matrix_Set_Task(task);
+
+    /* The first scan finds nothing held and arms the wake interrupt on every Row. */
+    test_run_scheduler(10000U);
+    TEST_CHECK(test_task_runs == 1U);
+    TEST_CHECK(task->timing == TASK_EVENT_DRIVEN);
+    TEST_CHECK((EIMSK & 0x0FU) == 0x0FU);
+
+    /* No scans at all while idle. */
+    test_run_scheduler(1000000U);
+    TEST_CHECK(test_task_runs == 1U);
+
+    /* The press pulls its Row up through the strobed Column and raises the interrupt. */
+    Host_PCB_Set_Key(2U, 5U, true);
+    Host_Systick_Advance_Us(300U);
+    PCINT0_vect();
+    TEST_CHECK((EIMSK & 0x0FU) == 0U);
+    TEST_CHECK(task->timing == TASK_FIXED_DELAY);
+
+    Begin_Scheduler();
+    TEST_CHECK(test_task_runs == 2U);
+
+    test_run_scheduler(timeout_ms * 1000U);
+    TEST_CHECK(Key_Event_Pop(&event));
+    TEST_CHECK(event.pressed == 1U);
+    TEST_CHECK(event.row == 2U);
+    TEST_CHECK(event.column == 5U);
+    TEST_CHECK(task->timing == TASK_FIXED_DELAY);
+
+    /* Once released and quiet again the scans stop. */
+    Host_PCB_Set_Key(2U, 5U, false);
+    test_run_scheduler(timeout_ms * 1000U);
+    TEST_CHECK(Key_Event_Pop(&event));
+    TEST_CHECK(event.pressed == 0U);
+    TEST_CHECK(task->timing == TASK_EVENT_DRIVEN);
+
+    const unsigned runs = test_task_runs;
+    test_run_scheduler(100000U);
+    TEST_CHECK(test_task_runs == runs);
+
+    cli();
+    Systick_Stop();
+    Clear_Scheduler();
+    Matrix_Set_Task(NULL);
+}
+#endif
+
+
+/**
+ * @brief The systick counts simulated time once started, and only while interrupts are enabled.
+ * 
+ */
+static void test_systick(void);
+static void test_systick(void)
+{
+    Systick_Time_t time;
+
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+
+    Host_Systick_Advance_Us(2500U);
+    TEST_CHECK(Systick_Get_Ms() == 2U);
+
+    Systick_Get_Time(&time);
+    TEST_CHECK(time.ms == 2U);
+
+    _delay_us(700);
+    TEST_CHECK(Systick_Get_Ms() == 3U);
+
+    cli();
+    Host_Systick_Advance_Us(5000U);
+    TEST_CHECK(Systick_Get_Ms() == 3U);
+
+    sei();
+    Host_Systick_Service();
+    TEST_CHECK(Systick_Get_Ms() == 4U);
+
+    Systick_Stop();
+}
+
+
+/**
+ * @brief A held key is queued as a press once debounced and as a release once let go, at its own row and column.
+ * 
+ */
+static void test_matrix_press_release(void);
+static void test_matrix_press_release(void)
+{
+    const uint32_t timeout_ms = (uint32_t)(KB_DEBOUNCE_TIME_MS) + (KB_MATRIX_SCAN_PERIOD_MAX_MS) + 10U;
+    Key_Event_t event;
+
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+    Matrix_Init();
+
+    Host_PCB_Set_Key(KB_NUMBER_OF_ROWS - 1U, 2U, true);
+    TEST_CHECK(test_scan_until_event(&event, timeout_ms));
+    TEST_CHECK(event.pressed == 1U);
+    TEST_CHECK(event.row == KB_NUMBER_OF_ROWS - 1U);
+    TEST_CHECK(event.column == 2U);
+    TEST_CHECK(!test_scan_until_event(&event, 20U));
+
+    Host_PCB_Set_Key(KB_NUMBER_OF_ROWS - 1U, 2U, false);
+    TEST_CHECK(test_scan_until_event(&event, timeout_ms));
+    TEST_CHECK(event.pressed == 0U);
+    TEST_CHECK(event.row == KB_NUMBER_OF_ROWS - 1U);
+    TEST_CHECK(event.column == 2U);
+
+    cli();
+    Systick_Stop();
+}
+
+
+/**
+ * @brief KB_DEBOUNCE_VERTICAL_COUNTER registers a change on the 4th consecutive scan that sees it, in either 
+ * direction. A scan that reads the debounced state again restarts the count. It counts scans rather than time, 
+ * so a whole word of keys changes together even with the systick standing still.
+ * 
+ */
+static void test_debounce_vertical_counter(void);
+static void test_debounce_vertical_counter(void)
+{
+    test_debounce_reset(KB_DEBOUNCE_VERTICAL_COUNTER, KB_DEBOUNCE_TIME_MS, KB_DEBOUNCE_TIME_MS);
+
+    TEST_CHECK(test_debounce_key(true, 10U) == 3U);
+    TEST_CHECK(test_debounce_key(false, 10U) == 3U);
+
+    /* Bounces back after 3 scans, so the count starts over. */
+    TEST_CHECK(test_debounce_key(true, 2U) == UINT32_MAX);
+    TEST_CHECK(test_debounce_key(false, 0U) == 0U);
+    TEST_CHECK(test_debounce_key(true, 10U) == 3U);
+
+    for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++)
+    {
+        test_raw[o] = (matrix_word_t)~(matrix_word_t)0;
+    }
+
+    for (uint8_t scan = 0; scan < 3U; scan++)
+    {
+        Debounce_Matrix(test_raw, test_debounced);
+    }
+    TEST_CHECK(test_debounced[0] == 1U);
+    TEST_CHECK(test_debounced[MATRIX_NUMBER_OF_STROBES - 1U] == 0U);
+
+    Debounce_Matrix(test_raw, test_debounced);
+    for (uint8_t o = 0; o < MATRIX_NUMBER_OF_STROBES; o++)
+    {
+        TEST_CHECK(test_debounced[o] == (matrix_word_t)~(matrix_word_t)0);
+    }
+
+    cli();
+    Systick_Stop();
+}
+
+
+/**
+ * @brief KB_DEBOUNCE_DEFERRED registers a change once it has been seen for the whole window. A bounce back 
+ * before then restarts the window.
+ * 
+ */
+static void test_debounce_deferred(void);
+static void test_debounce_deferred(void)
+{
+    test_debounce_reset(KB_DEBOUNCE_DEFERRED, 5U, 5U);
+
+    TEST_CHECK(test_debounce_key(true, 20U) == 5U);
+    TEST_CHECK(test_debounce_key(false, 20U) == 5U);
+
+    TEST_CHECK(test_debounce_key(true, 2U) == UINT32_MAX);
+    TEST_CHECK(test_debounce_key(false, 0U) == 0U);
+    TEST_CHECK(test_debounce_key(true, 20U) == 5U);
+
+    cli();
+    Systick_Stop();
+}
+
+
+/**
+ * @brief KB_DEBOUNCE_EAGER registers a change on the first scan that sees it, then locks the key out for the 
+ * window. A change during the lockout is registered by the scan that ends it.
+ * 
+ */
+static void test_debounce_eager(void);
+static void test_debounce_eager(void)
+{
+    test_debounce_reset(KB_DEBOUNCE_EAGER, 5U, 5U);
+
+    TEST_CHECK(test_debounce_key(true, 20U) == 0U);
+    TEST_CHECK(test_debounce_key(false, 20U) == 5U);
+    TEST_CHECK(test_debounce_key(true, 20U) == 5U);
+
+    /* Once the key has been stable for the window, the next change is immediate again. */
+    Host_Systick_Advance_Us(5000U);
+    Debounce_Matrix(test_raw, test_debounced);
+    TEST_CHECK(test_debounce_key(false, 20U) == 0U);
+
+    cli();
+    Systick_Stop();
+}
+
+
+/**
+ * @brief KB_DEBOUNCE_ASYMMETRIC defers presses and releases by their own windows.
+ * 
+ */
+static void test_debounce_asymmetric(void);
+static void test_debounce_asymmetric(void)
+{
+    test_debounce_reset(KB_DEBOUNCE_ASYMMETRIC, 2U, 5U);
+
+    TEST_CHECK(test_debounce_key(true, 20U) == 2U);
+    TEST_CHECK(test_debounce_key(false, 20U) == 5U);
+    TEST_CHECK(test_debounce_key(true, 20U) == 2U);
+
+    cli();
+    Systick_Stop();
+}
+
+
+/**
+ * @brief A periodic task runs once per period of simulated time, first one period after it is created.
+ * 
+ */
+static void test_scheduler_period(void);
+static void test_scheduler_period(void)
+{
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+
+    Task_t* const task = Create_Task(test_counting_task, 10);
+    Task_Stats_t stats;
+    TEST_CHECK(task != NULL);
+
+    for (uint32_t us = 0; us <= 100000U; us += 50U)
+    {
+        Begin_Scheduler();
+        Host_Systick_Advance_Us(50U);
+    }
+    TEST_CHECK(test_task_runs == 10U);
+
+    /* SCHEDULER_TASK_STATS is enabled in the host build only. */
+    TEST_CHECK(Get_Task_Stats(task, &stats));
+    TEST_CHECK(stats.runs == 10U);
+
+    cli();
+    Systick_Stop();
+    Clear_Scheduler();
+}
+
+/**
+ * @brief Signalling a periodic task, as the matrix wake interrupt does, makes it due on the next pass 
+ * and restarts its period from there.
+ * 
+ */
+static void test_scheduler_signal_periodic(void);
+static void test_scheduler_signal_periodic(void)
+{
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+
+    Task_t* const task = Create_Task(test_counting_task, 100);
+    TEST_CHECK(task != NULL);
+
+    Host_Systick_Advance_Us(10000U);
+    Begin_Scheduler();
+    TEST_CHECK(test_task_runs == 0U);
+
+    Signal_Task(task);
+    Begin_Scheduler();
+    TEST_CHECK(test_task_runs == 1U);
+
+    /* The next run is a full period after the signalled one, not at the original 100 ms. */
+    Host_Systick_Advance_Us(99000U);
+    Begin_Scheduler();
+    TEST_CHECK(test_task_runs == 1U);
+
+    Host_Systick_Advance_Us(1000U);
+    Begin_Scheduler();
+    TEST_CHECK(test_task_runs == 2U);
+
+    cli();
+    Systick_Stop();
+    Clear_Scheduler();
+}
+
+
+/**
+ * @brief Tasks with different periods run in the order they fall due, not the order they were created, and a 
+ * deleted task is taken out of the queue without disturbing the others.
+ * 
+ */
+static void test_scheduler_deadline_order(void);
+static void test_scheduler_deadline_order(void)
+{
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+
+    TEST_CHECK(Create_Task(test_task_a, 7) != NULL);
+    Task_t* const b = Create_Task(test_task_b, 3);
+    TEST_CHECK(b != NULL);
+    TEST_CHECK(Create_Task(test_task_c, 5) != NULL);
+
+    /* b at 3, c at 5, b at 6, a at 7, b at 9 and c at 10. */
+    test_run_scheduler(10050U);
+    TEST_CHECK(strcmp(test_log, "bcbabc") == 0);
+
+    /* Without b, a at 14, c at 15 and c at 20. */
+    Delete_Task(b);
+    test_run_scheduler(10000U);
+    TEST_CHECK(strcmp(test_log, "bcbabcacc") == 0);
+
+    cli();
+    Systick_Stop();
+    Clear_Scheduler();
+}
+
+
+/**
+ * @brief After an overrun, TASK_FIXED_RATE_CATCH_UP runs the missed executions back to back and 
+ * TASK_FIXED_RATE_SKIP drops them. Either way the task is back on its original 10ms phase afterwards.
+ * 
+ */
+static void test_scheduler_fixed_rate_overrun(void);
+static void test_scheduler_fixed_rate_overrun(void)
+{
+    static const systick_wordsize_t catch_up_ms[] = {10U, 45U, 45U, 45U, 50U, 60U};
+    static const systick_wordsize_t skip_ms[] = {10U, 50U, 60U};
+
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+
+    Task_t* task = Create_Task(test_overrun_task, 10);
+    TEST_CHECK(task != NULL);
+    Set_Task_Timing(task, TASK_FIXED_RATE_CATCH_UP);
+
+    test_run_scheduler(60050U);
+    TEST_CHECK(test_task_runs == (sizeof(catch_up_ms) / sizeof(catch_up_ms[0])));
+    TEST_CHECK(memcmp(test_run_ms, catch_up_ms, sizeof(catch_up_ms)) == 0);
+
+    cli();
+    Systick_Stop();
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+
+    task = Create_Task(test_overrun_task, 10);
+    TEST_CHECK(task != NULL);
+    Set_Task_Timing(task, TASK_FIXED_RATE_SKIP);
+
+    test_run_scheduler(60050U);
+    TEST_CHECK(test_task_runs == (sizeof(skip_ms) / sizeof(skip_ms[0])));
+    TEST_CHECK(memcmp(test_run_ms, skip_ms, sizeof(skip_ms)) == 0);
+
+    cli();
+    Systick_Stop();
+    Clear_Scheduler();
+}
+
+
+/**
+ * @brief Of the tasks due on a pass, the highest priority one runs first whatever order they were created in. 
+ * A high priority task signalled by a low priority one runs before the other low priority tasks already due.
+ * 
+ */
+static void test_scheduler_priority(void);
+static void test_scheduler_priority(void)
+{
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+
+    Task_t* const a = Create_Task(test_task_a, 10);
+    Task_t* const b = Create_Task(test_task_b, 10);
+    Task_t* const c = Create_Task(test_task_c, 10);
+    TEST_CHECK((a != NULL) && (b != NULL) && (c != NULL));
+    Set_Task_Priority(a, TASK_PRIORITY_LOW);
+    Set_Task_Priority(b, TASK_PRIORITY_NORMAL);
+    Set_Task_Priority(c, TASK_PRIORITY_HIGH);
+
+    test_run_scheduler(10200U);
+    TEST_CHECK(strcmp(test_log, "cba") == 0);
+
+    cli();
+    Systick_Stop();
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+
+    /* s and a are due together and run in the order they were created. */
+    Task_t* const s_task = Create_Task(test_task_s, 10);
+    Task_t* const a_task = Create_Task(test_task_a, 10);
+    test_signal_target = Create_Event_Task(test_task_c);
+    TEST_CHECK((s_task != NULL) && (a_task != NULL) && (test_signal_target != NULL));
+    Set_Task_Priority(s_task, TASK_PRIORITY_LOW);
+    Set_Task_Priority(a_task, TASK_PRIORITY_LOW);
+    Set_Task_Priority(test_signal_target, TASK_PRIORITY_HIGH);
+
+    test_run_scheduler(10200U);
+    TEST_CHECK(strcmp(test_log, "sca") == 0);
+
+    cli();
+    Systick_Stop();
+    Clear_Scheduler();
+}
+
+
+/**
+ * @brief An event-driven task never runs on its own. Signals before it runs coalesce into one run on the next 
+ * pass, and a signal while it is executing makes it run exactly once more.
+ * 
+ */
+static void test_scheduler_event_task(void);
+static void test_scheduler_event_task(void)
+{
+    test_reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+
+    Task_t* const task = Create_Event_Task(test_counting_task);
+    TEST_CHECK(task != NULL);
+    TEST_CHECK(task->timing == TASK_EVENT_DRIVEN);
+
+    test_run_scheduler(100000U);
+    TEST_CHECK(test_task_runs == 0U);
+
+    /* Signalled from an ISR. */
+    cli();
+    Signal_Task(task);
+    Signal_Task(task);
+    sei();
+    Begin_Scheduler();
+    TEST_CHECK(test_task_runs == 1U);
+
+    test_run_scheduler(100000U);
+    TEST_CHECK(test_task_runs == 1U);
+
+    /* test_task_s() signals itself the first time it runs. */
+    test_signal_target = Create_Event_Task(test_task_s);
+    TEST_CHECK(test_signal_target != NULL);
+    Signal_Task(test_signal_target);
+
+    test_run_scheduler(1000U);
+    TEST_CHECK(strcmp(test_log, "ss") == 0);
+
+    test_run_scheduler(100000U);
+    TEST_CHECK(strcmp(test_log, "ss") == 0);
+    TEST_CHECK(test_task_runs == 1U);
+
+    cli();
+    Systick_Stop();
+    Clear_Scheduler();
+}
+
+
+/**
+ * @brief The free-running head and tail wrap through 0xFF without losing or reordering elements, and a full 
+ * buffer refuses writes.
+ * 
+ */
+static void test_circbuf_wrap(void);
+static void test_circbuf_wrap(void)
+{
+    uint16_t value = 0;
+
+    circbuf_init(&test_circbuf);
+
+    for (uint16_t i = 0; i < 300U; i++)
+    {
+        TEST_CHECK(circbuf_write(&test_circbuf, &i) == 1U);
+        TEST_CHECK(circbuf_count(&test_circbuf) == 1U);
+        TEST_CHECK(circbuf_read(&test_circbuf, &value) == 1U);
+        TEST_CHECK(value == i);
+    }
+    TEST_CHECK(test_circbuf.head == (uint8_t)300U);
+    TEST_CHECK(test_circbuf.tail == (uint8_t)300U);
+    TEST_CHECK(circbuf_read(&test_circbuf, &value) == 0U);
+
+    for (uint16_t i = 0; i < 8U; i++)
+    {
+        TEST_CHECK(circbuf_write(&test_circbuf, &i) == 1U);
+    }
+    TEST_CHECK(circbuf_count(&test_circbuf) == 8U);
+    TEST_CHECK(circbuf_write(&test_circbuf, &value) == 0U);
+}
+
+
+/**
+ * @brief Bulk writes stop when the buffer fills and bulk reads when it empties, each returning how many 
+ * elements moved. Elements come out in the order they went in across the wrap.
+ * 
+ */
+static void test_circbuf_bulk(void);
+static void test_circbuf_bulk(void)
+{
+    const uint16_t in[8] = {1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U};
+    static const uint16_t expected[8] = {4U, 5U, 1U, 2U, 3U, 4U, 5U, 6U};
+    uint16_t out[16] = {0};
+
+    circbuf_init(&test_circbuf);
+
+    TEST_CHECK(circbuf_write_bulk(&test_circbuf, in, 5U) == 5U);
+    TEST_CHECK(circbuf_read_bulk(&test_circbuf, out, 3U) == 3U);
+    TEST_CHECK((out[0] == 1U) && (out[1] == 2U) && (out[2] == 3U));
+
+    /* 2 elements are still stored, so only 6 of the 8 fit. */
+    TEST_CHECK(circbuf_write_bulk(&test_circbuf, in, 8U) == 6U);
+    TEST_CHECK(circbuf_read_bulk(&test_circbuf, out, 16U) == 8U);
+    TEST_CHECK(memcmp(out, expected, sizeof(expected)) == 0);
+    TEST_CHECK(circbuf_read_bulk(&test_circbuf, out, 16U) == 0U);
+}
+
+
+/**
+ * @brief With the index part way through the storage, peeking hands out the free slots and then the stored 
+ * elements as two spans split at the end of the storage. Committing moves the index by what was used.
+ * 
+ */
+static void test_circbuf_spans(void);
+static void test_circbuf_spans(void)
+{
+    uint16_t out[6] = {0};
+    circbuf_span_t spans[2];
+    uint16_t value = 100U;
+
+    circbuf_init(&test_circbuf);
+    TEST_CHECK(circbuf_write_bulk(&test_circbuf, out, 6U) == 6U);
+    TEST_CHECK(circbuf_read_bulk(&test_circbuf, out, 6U) == 6U);
+
+    TEST_CHECK(circbuf_peek_writable(&test_circbuf, spans) == 8U);
+    TEST_CHECK((spans[0].data == (uint8_t *)&test_circbuf_storage[6]) && (spans[0].count == 2U));
+    TEST_CHECK((spans[1].data == (uint8_t *)&test_circbuf_storage[0]) && (spans[1].count == 6U));
+
+    /* Fill 5 slots in place, 2 from the first span and 3 from the second. */
+    for (uint8_t i = 0; i < 2U; i++)
+    {
+        ((uint16_t *)spans[0].data)[i] = value++;
+    }
+    for (uint8_t i = 0; i < 3U; i++)
+    {
+        ((uint16_t *)spans[1].data)[i] = value++;
+    }
+    circbuf_commit_write(&test_circbuf, 5U);
+    TEST_CHECK(circbuf_count(&test_circbuf) == 5U);
+
+    TEST_CHECK(circbuf_peek_readable(&test_circbuf, spans) == 5U);
+    TEST_CHECK((spans[0].data == (uint8_t *)&test_circbuf_storage[6]) && (spans[0].count == 2U));
+    TEST_CHECK((spans[1].data == (uint8_t *)&test_circbuf_storage[0]) && (spans[1].count == 3U));
+    TEST_CHECK(((uint16_t *)spans[0].data)[0] == 100U);
+    TEST_CHECK(((uint16_t *)spans[1].data)[2] == 104U);
+
+    circbuf_commit_read(&test_circbuf, 5U);
+    TEST_CHECK(circbuf_count(&test_circbuf) == 0U);
+    TEST_CHECK(circbuf_peek_readable(&test_circbuf, spans) == 0U);
+}
+
+
+/**
+ * @brief Every transition in test_hsm_tran_paths runs the same Exit and Entry Events when it is looked up in the 
+ * table as when Hsm_Run_Tran() works it out, including a transition made by a superstate of the current state 
+ * and a nested transition.
+ * 
+ */
+static void test_hsm_tran_paths_match(void);
+static void test_hsm_tran_paths_match(void)
+{
+    static const struct
+    {
+        const HsmState * start;
+        Signal sig;
+        const char * expected;
+        const HsmState * end;
+    } cases[] =
+    {
+        {&test_hsm_a11, TEST_HSM_A11_TO_B1_SIG,     "A11- A1- A- B+ B1+",       &test_hsm_b1},
+        {&test_hsm_a11, TEST_HSM_A11_TO_A1_SIG,     "A11- A1- A1+",             &test_hsm_a1},
+        {&test_hsm_a11, TEST_HSM_A_TO_A11_SIG,      "A11- A1- A- A+ A1+ A11+",  &test_hsm_a11},
+        {&test_hsm_a11, TEST_HSM_A_INTERNAL_A1_SIG, "A11- A1- A1+",             &test_hsm_a1},
+        {&test_hsm_b1,  TEST_HSM_B1_TO_A11_SIG,     "B1- B- A+ A1+ A11+",       &test_hsm_a11},
+    };
+    char run_time[sizeof(test_log)];
+
+    test_reset();
+
+    for (uint8_t i = 0; i < (sizeof(cases) / sizeof(cases[0])); i++)
+    {
+        test_hsm_dispatch((HsmTranPath *)0, cases[i].start, cases[i].sig);
+        TEST_CHECK(strcmp(test_log, cases[i].expected) == 0);
+        TEST_CHECK(test_hsm.state == cases[i].end);
+        memcpy(run_time, test_log, sizeof(run_time));
+
+        test_hsm_dispatch(test_hsm_tran_paths, cases[i].start, cases[i].sig);
+        TEST_CHECK(strcmp(test_log, run_time) == 0);
+        TEST_CHECK(test_hsm.state == cases[i].end);
+    }
+}
+
+
+int main(void)
+{
+    test_systick();
+    test_matrix_press_release();
+    test_debounce_deferred();
+    test_debounce_eager();
+    test_debounce_asymmetric();
+    test_debounce_vertical_counter();
+    test_scheduler_period();
+    test_scheduler_signal_periodic();
+    test_scheduler_deadline_order();
+    test_scheduler_fixed_rate_overrun();
+    test_scheduler_priority();
+    test_scheduler_event_task();
+    test_circbuf_wrap();
+    test_circbuf_bulk();
+    test_circbuf_spans();
+    test_hsm_tran_paths_match();
+#if (KB_MATRIX_IDLE_WAKE_INTERRUPT == 1)
+    test_matrix_idle_wake();
+#endif
+
+    printf("%u checks, %u failures\n", test_checks, test_failures);
+    return (test_failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file host_systick_test.c
+ * @author Ian Ress
+ * @brief Checks the target's systick.c against the TIM1 model in tests/tim1. Built by the host target in
+ * CMakeLists.txt and run with ctest. Prints every failed check and returns non-zero if any check failed.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <avr/interrupt.h>
+#include "host_io.h"
+#include "host_tim1.h"
+#include "systick.h"
+
+/**
+ * @brief Records a failed check without stopping the test so every failure is reported.
+ * 
+ */
+#define TEST_CHECK(condition)                                                               \
+    do                                                                                      \
+    {                                                                                       \
+        test_checks++;                                                                      \
+        if (!(condition))                                                                   \
+        {                                                                                   \
+            test_failures++;                                                                \
+            printf("%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #condition); \
+        }                                                                                   \
+    } while (0)
+
+static unsigned test_checks = 0;
+static unsigned test_failures = 0;
+static uint32_t test_wake_ms32 = 0;
+
+
+/**
+ * @brief Resets the simulation and starts the systick. Every test starts from here.
+ * 
+ */
+static void test_reset(void);
+static void test_reset(void)
+{
+    Host_IO_Reset();
+    Host_Systick_Reset();
+    Systick_Init();
+    Systick_Start();
+    sei();
+}
+
+
+/**
+ * @brief Stands in for the matrix wake interrupt. Records the time it sees while the tick is stretched.
+ * 
+ */
+static void test_wake(void);
+static void test_wake(void)
+{
+    test_wake_ms32 = Systick_Get_Ms32();
+}
+
+
+/**
+ * @brief A sleep that runs to the end of its stretched tick advances g_ms by the whole sleep.
+ * 
+ */
+static void test_sleep(void);
+static void test_sleep(void)
+{
+    test_reset();
+    Host_Systick_Advance_Us(3000U);
+    TEST_CHECK(Systick_Get_Ms() == 3U);
+
+    cli();
+    Systick_Sleep(10);
+    TEST_CHECK(Systick_Get_Ms() == 13U);
+    TEST_CHECK(Host_Systick_Now_Us() == 13000U);
+
+    Host_Systick_Advance_Us(1000U);
+    TEST_CHECK(Systick_Get_Ms() == 14U);
+
+    Systick_Stop();
+}
+
+
+/**
+ * @brief A sleep across the 0xFFFF boundary that another interrupt ends early still rolls g_ms_epoch over, and
+ * the interrupt reads the current time while the tick is stretched.
+ * 
+ */
+static void test_sleep_woken_across_rollover(void);
+static void test_sleep_woken_across_rollover(void)
+{
+    test_reset();
+    g_ms = 0xFFF0U;
+
+    Host_TIM1_Set_Wake(20500U, test_wake);
+    cli();
+    Systick_Sleep(30);
+
+    TEST_CHECK(test_wake_ms32 == 0x10004UL);
+    TEST_CHECK(Systick_Get_Ms32() == 0x10004UL);
+
+    /* TCNT1 keeps the partial tick, so the cut short tick ends on the original 1ms phase. */
+    Host_Systick_Advance_Us(499U);
+    TEST_CHECK(Systick_Get_Ms32() == 0x10004UL);
+    Host_Systick_Advance_Us(1U);
+    TEST_CHECK(!g_ms_stretched);
+    TEST_CHECK(g_ms == 0x0005U);
+    TEST_CHECK(g_ms_epoch == 1U);
+    TEST_CHECK(Systick_Get_Ms32() == 0x10005UL);
+
+    Systick_Stop();
+}
+
+
+/**
+ * @brief Early wakes do not lose the counts that pass while Systick_Sleep() works out where the stretched 
+ * tick ends, E.g. with a USB Start of Frame waking the CPU every 1ms. Each TCNT1 read costs about as much as 
+ * a 32-bit division on the target.
+ * 
+ */
+static void test_sleep_woken_every_ms(void);
+static void test_sleep_woken_every_ms(void)
+{
+    test_reset();
+    Host_TIM1_Set_Read_Cost(150U);
+
+    for (uint8_t i = 0; i < 100U; i++)
+    {
+        Host_TIM1_Set_Wake(1000U, test_wake);
+        cli();
+        Systick_Sleep(30);
+    }
+
+    TEST_CHECK(Systick_Get_Ms32() == (uint32_t)(Host_Systick_Now_Us() / 1000U));
+
+    Host_TIM1_Set_Read_Cost(0U);
+    Host_Systick_Advance_Us(1000U);
+    TEST_CHECK(!g_ms_stretched);
+    TEST_CHECK(g_ms == (systick_wordsize_t)(Host_Systick_Now_Us() / 1000U));
+
+    Systick_Stop();
+}
+
+
+/**
+ * @brief An early wake just before a tick boundary whose counter passes that boundary while Systick_Sleep() 
+ * works it out still ends the stretched tick on the following boundary instead of running on to 0xFFFF.
+ * 
+ */
+static void test_sleep_woken_at_boundary(void);
+static void test_sleep_woken_at_boundary(void)
+{
+    test_reset();
+    Host_TIM1_Set_Read_Cost(150U);
+
+    Host_TIM1_Set_Wake(20950U, test_wake);
+    cli();
+    Systick_Sleep(30);
+    TEST_CHECK(g_ms_stretched);
+
+    Host_TIM1_Set_Read_Cost(0U);
+    Host_Systick_Advance_Us(22000U - (uint32_t)Host_Systick_Now_Us());
+    TEST_CHECK(!g_ms_stretched);
+    TEST_CHECK(g_ms == 22U);
+
+    Host_Systick_Advance_Us(1000U);
+    TEST_CHECK(g_ms == 23U);
+
+    Systick_Stop();
+}
+
+
+int main(void)
+{
+    test_sleep();
+    test_sleep_woken_across_rollover();
+    test_sleep_woken_every_ms();
+    test_sleep_woken_at_boundary();
+
+    printf("%u checks, %u failures\n", test_checks, test_failures);
+    return (test_failures == 0U) ? 0 : 1;
+}
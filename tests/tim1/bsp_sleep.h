@@ -0,0 +1,19 @@
+/**
+ * @file bsp_sleep.h
+ * @author Ian Ress
+ * @brief Host stand-in for the target's bsp_sleep.h. Idle mode advances the TIM1 model until an interrupt
+ * runs. See host_tim1.h.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef BSP_SLEEP_H_
+#define BSP_SLEEP_H_
+
+#include "host_tim1.h"
+
+#define BSP_Sleep_Idle()                        Host_TIM1_Sleep()
+
+#endif /* BSP_SLEEP_H_ */
@@ -0,0 +1,25 @@
+/**
+ * @file bsp_tim1.h
+ * @author Ian Ress
+ * @brief Host stand-in for the target's bsp_tim1.h. Accesses the TIM1 model instead of TCNT1, OCR1A and
+ * TIFR1. See host_tim1.h.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef BSP_TIM1_H_
+#define BSP_TIM1_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "host_tim1.h"
+
+#define BSP_TIM1_Get_Count()                    Host_TIM1_Get_Count()
+#define BSP_TIM1_Set_Count(count)               Host_TIM1_Set_Count(count)
+#define BSP_TIM1_Get_Top()                      Host_TIM1_Get_Top()
+#define BSP_TIM1_Set_Top(top)                   Host_TIM1_Set_Top(top)
+#define BSP_TIM1_Compare_Pending()              Host_TIM1_Compare_Pending()
+
+#endif /* BSP_TIM1_H_ */
@@ -0,0 +1,307 @@
+/**
+ * @file host_tim1.c
+ * @author Ian Ress
+ * @brief Model of TIM1 for running src/mainapp/systick.c on a Linux host. See host_tim1.h.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "host_io.h"
+#include "host_tim1.h"
+#include "timer.h"
+
+static uint64_t clock_counts = 0;               /* Simulated time since Host_Systick_Reset() in TIM1 counts. Always runs. */
+static uint16_t count = 0;                      /* TCNT1. */
+static uint16_t top = 0;                        /* OCR1A. */
+static bool running = false;                    /* True between TIM1.start() and TIM1.stop(). */
+static bool pending = false;                    /* OCF1A. Latched on a compare match, cleared when the ISR runs. */
+static void (*isr)(void) = NULL;                /* Compare Match A interrupt. */
+static uint32_t isr_runs = 0;                   /* Number of times isr ran. Ends Host_TIM1_Sleep(). */
+static Host_Systick_Hook_t tick_hook = NULL;
+static uint32_t wake_counts = 0;                /* Counts until wake runs. */
+static Host_TIM1_Wake_t wake = NULL;
+static uint32_t read_cost = 0;                  /* Counts that pass after every TCNT1 read. See Host_TIM1_Set_Read_Cost(). */
+
+
+/**
+ * @brief Counts until the next compare match. A counter already past TOP runs on to 0xFFFF and wraps first.
+ * 
+ */
+static uint32_t tim1_counts_to_match(void);
+static uint32_t tim1_counts_to_match(void)
+{
+    if (count <= top)
+    {
+        return ((uint32_t)top + 1U) - count;
+    }
+    return (0x10000UL - count) + top + 1U;
+}
+
+
+/**
+ * @brief Advances simulated time. The counter only runs while TIM1 is started. Every compare match latches
+ * the interrupt flag and runs the ISR straight away if interrupts are enabled.
+ * 
+ * @param counts TIM1 counts to advance.
+ * 
+ */
+static void tim1_advance(uint32_t counts);
+static void tim1_advance(uint32_t counts)
+{
+    while (counts)
+    {
+        uint32_t step = tim1_counts_to_match();
+
+        if (!running || (step > counts))
+        {
+            step = counts;
+        }
+
+        counts -= step;
+        clock_counts += step;
+
+        if (!running)
+        {
+            continue;
+        }
+
+        if (step == tim1_counts_to_match())
+        {
+            count = 0;
+            pending = true;
+            Host_Systick_Service();
+        }
+        else
+        {
+            count = (uint16_t)(count + step);
+        }
+    }
+}
+
+
+/**
+ * @brief TIM1.init(). Sets TOP so the counter matches once every @p period_ms.
+ * 
+ */
+static void tim1_init(uint8_t period_ms);
+static void tim1_init(uint8_t period_ms)
+{
+    count = 0;
+    top = (uint16_t)(((uint32_t)period_ms * 1000U * HOST_TIM1_COUNTS_PER_US) - 1U);
+    pending = false;
+}
+
+
+/**
+ * @brief TIM1.start(). Starts counting and enables the Compare Match A interrupt.
+ * 
+ */
+static void tim1_start(void (*handler)(void));
+static void tim1_start(void (*handler)(void))
+{
+    isr = handler;
+    running = true;
+}
+
+
+/**
+ * @brief TIM1.stop().
+ * 
+ */
+static void tim1_stop(void);
+static void tim1_stop(void)
+{
+    running = false;
+}
+
+const timer1_t TIM1 = {tim1_init, tim1_start, tim1_stop};
+
+
+/**
+ * @brief Stops TIM1, removes the hooks and sets the simulated time back to 0. g_ms is owned by systick.c, so
+ * it is cleared here too.
+ * 
+ */
+void Host_Systick_Reset(void)
+{
+    g_ms = 0;
+    g_ms_epoch = 0;
+    clock_counts = 0;
+    count = 0;
+    running = false;
+    pending = false;
+    isr = NULL;
+    isr_runs = 0;
+    tick_hook = NULL;
+    wake = NULL;
+    read_cost = 0;
+}
+
+
+/**
+ * @brief Installs the function called after every systick interrupt.
+ * 
+ * @param hook The hook. NULL removes the current hook.
+ * 
+ */
+void Host_Systick_Set_Hook(Host_Systick_Hook_t hook)
+{
+    tick_hook = hook;
+}
+
+
+/**
+ * @brief Advances simulated time.
+ * 
+ * @param us Microseconds to advance.
+ * 
+ */
+void Host_Systick_Advance_Us(uint32_t us)
+{
+    tim1_advance(us * HOST_TIM1_COUNTS_PER_US);
+}
+
+
+/**
+ * @brief Runs the Compare Match A interrupt if its flag is latched and interrupts are enabled. Called when
+ * interrupts are re-enabled.
+ * 
+ */
+void Host_Systick_Service(void)
+{
+    if (pending && running && (isr != NULL) && g_host_interrupts_enabled)
+    {
+        pending = false;
+        isr_runs++;
+        isr();
+
+        if (tick_hook != NULL)
+        {
+            tick_hook();
+        }
+    }
+}
+
+
+/**
+ * @brief Returns simulated time.
+ * 
+ * @return Microseconds since Host_Systick_Reset().
+ * 
+ */
+uint64_t Host_Systick_Now_Us(void)
+{
+    return clock_counts / HOST_TIM1_COUNTS_PER_US;
+}
+
+
+/**
+ * @brief Arms a simulated interrupt that ends the next Host_TIM1_Sleep() @p us after that sleep starts, unless
+ * a compare match ends it first.
+ * 
+ * @param us When the interrupt arrives, counted from the start of the sleep.
+ * @param handler Runs as the interrupt, with interrupts disabled.
+ * 
+ */
+void Host_TIM1_Set_Wake(uint32_t us, Host_TIM1_Wake_t handler)
+{
+    wake_counts = us * HOST_TIM1_COUNTS_PER_US;
+    wake = handler;
+}
+
+
+/**
+ * @brief Charges CPU time to every TCNT1 read. The counter advances by @p counts after the value is read, so 
+ * the code between a read and whatever it does with the value takes time like it does on the target.
+ * 
+ * @param counts TIM1 counts that pass after each read. 0 makes reads free again.
+ * 
+ */
+void Host_TIM1_Set_Read_Cost(uint32_t counts)
+{
+    read_cost = counts;
+}
+
+
+/**
+ * @brief BSP_Sleep_Idle(). Enables interrupts and advances simulated time until the Compare Match A
+ * interrupt or the interrupt armed with Host_TIM1_Set_Wake() runs.
+ * 
+ */
+void Host_TIM1_Sleep(void)
+{
+    const uint32_t runs = isr_runs;
+
+    Host_Interrupts_Restore(true);
+
+    while (isr_runs == runs)
+    {
+        uint32_t step = running ? tim1_counts_to_match() : 0U;
+
+        if ((wake != NULL) && ((step == 0U) || (wake_counts < step)))
+        {
+            const Host_TIM1_Wake_t handler = wake;
+
+            tim1_advance(wake_counts);
+            wake = NULL;
+
+            const bool enabled = Host_Interrupts_Disable();
+            handler();
+            Host_Interrupts_Restore(enabled);
+            return;
+        }
+
+        if (step == 0U)
+        {
+            return; /* Nothing left that could wake the CPU. */
+        }
+
+        if (wake != NULL)
+        {
+            wake_counts -= step;
+        }
+        tim1_advance(step);
+    }
+}
+
+
+/**
+ * @brief Register accessors behind bsp_tim1.h. Get/Set_Count is TCNT1, Get/Set_Top is OCR1A and 
+ * Compare_Pending is OCF1A.
+ * 
+ */
+uint16_t Host_TIM1_Get_Count(void)
+{
+    const uint16_t value = count;
+
+    tim1_advance(read_cost);
+    return value;
+}
+
+
+void Host_TIM1_Set_Count(uint16_t value)
+{
+    count = value;
+}
+
+
+uint16_t Host_TIM1_Get_Top(void)
+{
+    return top;
+}
+
+
+void Host_TIM1_Set_Top(uint16_t value)
+{
+    top = value;
+}
+
+
+bool Host_TIM1_Compare_Pending(void)
+{
+    return pending;
+}
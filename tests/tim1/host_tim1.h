@@ -0,0 +1,44 @@
+/**
+ * @file host_tim1.h
+ * @author Ian Ress
+ * @brief Model of TIM1 for running the target's own src/mainapp/systick.c on a Linux host. It stands in for
+ * host_systick.c, which replaces systick.c entirely, so the tick stretching done by Systick_Sleep() can be
+ * checked. The headers in this folder replace the target's timer.h, bsp_tim1.h and bsp_sleep.h, so it must
+ * come before src/drivers/avr/avr5/atmega16u4_atmega32u4 on the include path.
+ * 
+ * TIM1 counts at HOST_TIM1_COUNTS_PER_US in CTC mode, as the systick configures it on the target. The
+ * host_systick.h clock functions are implemented on top of it, so host_io.c and util/delay.h work unchanged.
+ * 
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef HOST_TIM1_H
+#define HOST_TIM1_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "host_systick.h"
+
+#define HOST_TIM1_COUNTS_PER_US                 2U  /* 16MHz with a prescaler of 8. */
+
+/**
+ * @brief Stands in for an interrupt other than the systick, E.g. a pin change, that wakes the CPU from
+ * BSP_Sleep_Idle().
+ * 
+ */
+typedef void (*Host_TIM1_Wake_t)(void);
+
+void Host_TIM1_Set_Wake(uint32_t us, Host_TIM1_Wake_t wake);
+void Host_TIM1_Sleep(void);
+void Host_TIM1_Set_Read_Cost(uint32_t counts);
+
+uint16_t Host_TIM1_Get_Count(void);
+void Host_TIM1_Set_Count(uint16_t count);
+uint16_t Host_TIM1_Get_Top(void);
+void Host_TIM1_Set_Top(uint16_t top);
+bool Host_TIM1_Compare_Pending(void);
+
+#endif /* HOST_TIM1_H */
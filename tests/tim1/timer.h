@@ -0,0 +1,24 @@
+/**
+ * @file timer.h
+ * @author Ian Ress
+ * @brief Host stand-in for the target's timer driver. Only TIM1 is provided. See host_tim1.h.
+ * @date 2023-02-15
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#ifndef HOST_TIMER_H
+#define HOST_TIMER_H
+
+#include <stdint.h>
+
+typedef struct {
+    void (*init)(uint8_t period_ms);
+    void (*start)(void (*isr)(void));
+    void (*stop)(void);
+} timer1_t;
+
+extern const timer1_t TIM1;
+
+#endif /* HOST_TIMER_H */